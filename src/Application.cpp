@@ -4,6 +4,7 @@
 #include "Application.hpp"
 
 #include "AsioFormatter.hpp"
+#include "BufferPool.hpp"
 #include "HttpClient.hpp"
 #include "OutgoingPacket.hpp"
 #include "ScopeExit.hpp"
@@ -12,6 +13,7 @@
 #include "serialization.hpp"
 
 #include <fmt/chrono.h>
+#include <fmt/ranges.h>
 #include <spdlog/spdlog.h>
 
 #include <codecvt>
@@ -19,6 +21,8 @@
 Application::Application(std::string configFileName)
   : m_configFileName(std::move(configFileName))
   , m_statisticTimer(m_ioContext.get_executor(), std::bind_front(&Application::statistic, this))
+  , m_evictionTimer(m_dbContext.get_executor(), std::bind_front(&Application::evictUsers, this))
+  , m_saveTimer(m_dbContext.get_executor(), std::bind_front(&Application::save, this))
 {
   m_listener = std::make_shared<Listener>(
     m_ioContext,
@@ -28,6 +32,8 @@ Application::Application(std::string configFileName)
       sess->setMessageHandler(std::bind(&Application::sessionMessageHandler, this, _1, _2));
       sess->setOpenHandler(std::bind(&Application::sessionOpenHandler, this, _1));
       sess->setCloseHandler(std::bind(&Application::sessionCloseHandler, this, _1));
+      sess->setDeflateOptions(m_config.server.deflate);
+      sess->setSendLimits(m_config.server.sendQueue);
       sess->run();
     }
   );
@@ -46,8 +52,15 @@ void Application::start()
     m_statisticTimer.start();
   }
 
+  m_sessionLogger.start(m_config.mysql.sessionLog);
   m_listener->start();
-  m_roomManager.start(m_config.room);
+  m_roomManager.start(m_config.room, m_config.server.deflate);
+  m_evictionTimer.setInterval(m_config.users.evictionInterval);
+  m_evictionTimer.start();
+  m_saveTimer.setInterval(m_config.users.saveInterval);
+  m_saveTimer.start();
+  m_tokenPool.start(m_config.users.tokenPool);
+  m_dbThreadPool.start(m_config.mysql.numThreads);
   m_ioThreadPool.start(m_config.server.numThreads);
 
   spdlog::info("Server started. address={}", m_config.server.address);
@@ -60,8 +73,14 @@ void Application::stop()
   m_influxdb.close();
   m_listener->stop();
   m_statisticTimer.stop();
+  m_evictionTimer.stop();
+  m_saveTimer.stop();
   m_ioThreadPool.stop();
+  m_dbThreadPool.stop();
+  m_tokenPool.stop();
   m_roomManager.stop();
+  m_sessionLogger.stop();
+  save();
 
   spdlog::info("Server stopped");
 }
@@ -69,7 +88,9 @@ void Application::stop()
 void Application::save()
 {
   try {
-    m_users.save();
+    if (auto count = m_users.save(m_config.users.saveBatchSize)) {
+      spdlog::debug("Saved {} users", count);
+    }
   } catch (const std::exception& e) {
     spdlog::warn("An exception occurred while saving data: {}", e.what());
   }
@@ -79,8 +100,65 @@ void Application::info()
 {
   std::lock_guard lock(m_mutex);
   spdlog::info("Websocket sessions: {}", m_sessions.size());
+  for (const auto& sess : m_sessions) {
+    if (auto stats = sess->getSendStats(); stats.droppedFrames) {
+      spdlog::info(
+        "Session {}: queuedBytes={} droppedFrames={}", sess->getRemoteEndpoint(), stats.queuedBytes,
+        stats.droppedFrames
+      );
+    }
+  }
   spdlog::info("MySQL connections: {}", m_mysqlConnectionPool.size());
+  {
+    auto stats = m_users.getStats();
+    spdlog::info(
+      "Users cache: size={} hits={} misses={} evictions={} modified={} saved={}", stats.size, stats.hits,
+      stats.misses, stats.evictions, stats.modified, stats.saved
+    );
+  }
+  {
+    auto stats = m_tokenPool.getStats();
+    spdlog::info(
+      "Token pool: size={} popped={} empty={} inserted={}", stats.size, stats.popped, stats.empty, stats.inserted
+    );
+  }
+  {
+    auto stats = m_sessionLogger.getStats();
+    spdlog::info(
+      "Session log: queued={} written={} dropped={} flushes={} lastFlush={}us maxFlush={}us", stats.queued,
+      stats.written, stats.dropped, stats.flushes, stats.lastFlush.count(), stats.maxFlush.count()
+    );
+  }
   spdlog::info("Rooms: {}", m_roomManager.size());
+  for (const auto& [id, stats] : m_roomManager.getGridmapStats()) {
+    spdlog::info(
+      "Room {} gridmap: power={} cells={} meanSectorCells={:.2f} maxSectorCells={} meanSectorsPerCell={:.2f} "
+      "histogram=[{}]",
+      id, stats.power, stats.cells, stats.meanSectorCells, stats.maxSectorCells, stats.meanSectorsPerCell,
+      fmt::join(stats.histogram, " ")
+    );
+  }
+  for (const auto& [id, pools] : m_roomManager.getPoolStats()) {
+    for (const auto& [type, stats] : pools) {
+      spdlog::info(
+        "Room {} {} pool: size={} capacity={} highWater={}", id, type, stats.size, stats.capacity, stats.highWater
+      );
+    }
+  }
+  for (const auto& [id, stats] : m_roomManager.getSyncStats()) {
+    spdlog::info(
+      "Room {} sync: count={} players={} prepare={}us params={}us frames={}us cleanup={}us maxTotal={}us",
+      id, stats.count, stats.players, stats.prepare.count(), stats.params.count(), stats.frames.count(),
+      stats.cleanup.count(), stats.maxTotal.count()
+    );
+  }
+}
+
+void Application::evictUsers()
+{
+  if (auto count = m_users.evict(m_config.users.ttl)) {
+    spdlog::debug("Evicted {} users from the cache", count);
+  }
 }
 
 void Application::sessionMessageHandler(const SessionPtr& sess, beast::flat_buffer& buffer) const
@@ -114,64 +192,89 @@ void Application::sessionCloseHandler(const SessionPtr& sess)
 {
   std::lock_guard lock(m_mutex);
   if (m_sessions.erase(sess)) {
-    try {
-      mysqlpp::Connection::thread_start();
-      ScopeExit onExit([] { mysqlpp::Connection::thread_end(); });
-      mysqlpp::ScopedConnection db(m_mysqlConnectionPool, true);
-      uint32_t userId = 0;
-      if (const auto& user = sess->user()) {
-        userId = user->getId();
-        sess->user(nullptr);
-      }
-      if (auto* room = sess->room()) {
-        room->leave(sess);
-        sess->room(nullptr);
-      }
-      auto query = db->query("INSERT INTO `sessions` (userId,begin,end,ip) VALUES (%0,%1q,%2q,%3)");
-      query.parse();
-      query.execute(
-        userId,
-        fmt::to_string(sess->created()),
-        fmt::to_string(SystemTimePoint::clock::now()),
-        sess->getRemoteEndpoint().address().to_v4().to_ulong()
-      );
-    } catch (const std::exception& e) {
-      spdlog::warn("An exception occurred while saving data: {}", e.what());
+    SessionRecord record;
+    if (const auto& user = sess->user()) {
+      record.userId = user->getId();
+      user->releaseSession(sess);
+      sess->user(nullptr);
     }
+    if (auto* room = sess->room()) {
+      room->leave(sess);
+      sess->room(nullptr);
+    }
+    record.begin = sess->created();
+    record.end = SystemTimePoint::clock::now();
+    record.ip = sess->getRemoteEndpoint().address().to_v4().to_ulong();
+    m_sessionLogger.log(record);
+  }
+}
+
+void Application::writeSessions(std::span<const SessionRecord> records)
+{
+  mysqlpp::Connection::thread_start();
+  ScopeExit onExit([] { mysqlpp::Connection::thread_end(); });
+  mysqlpp::ScopedConnection db(m_mysqlConnectionPool, true);
+  auto query = db->query();
+  query << "INSERT INTO `sessions` (userId,begin,end,ip) VALUES ";
+  for (size_t i = 0; i < records.size(); ++i) {
+    const auto& record = records[i];
+    query << (i ? ",(" : "(") << record.userId
+          << "," << mysqlpp::quote << fmt::to_string(record.begin)
+          << "," << mysqlpp::quote << fmt::to_string(record.end)
+          << "," << record.ip << ")";
   }
+  query.execute();
 }
 
 void Application::actionPing(const SessionPtr& sess, beast::flat_buffer& request)
 {
-  const auto& buffer = std::make_shared<Buffer>();
+  const auto& buffer = makeBuffer();
   OutgoingPacket::serializePong(*buffer);
   sess->send(buffer);
 }
 
 void Application::actionGreeting(const SessionPtr& sess, beast::flat_buffer& request)
 {
-  if (sess->user()) {
-    return; // user already logged in
+  auto sid = deserialize<std::string>(request);
+  if (sess->user() || !sess->startGreeting()) {
+    return; // user already logged in, or being looked up
+  }
+  auto ip = sess->getRemoteEndpoint().address().to_v4().to_ulong();
+  m_greetingService.greet(std::move(sid), ip, sess->getExecutor(),
+    [this, sess](const GreetingService::Result& result)
+    {
+      sess->finishGreeting();
+      if (result.user) {
+        greet(sess, result.user, result.created);
+      }
+    }
+  );
+}
+
+void Application::greet(const SessionPtr& sess, const UserPtr& user, bool created)
+{
+  {
+    std::lock_guard lock(m_mutex);
+    if (!m_sessions.contains(sess)) {
+      return; // closed while the user was looked up
+    }
+    if (created) {
+      ++m_registrations;
+    }
   }
 
   Room* room = nullptr;
 
-  auto sid = deserialize<std::string>(request);
-  auto user = m_users.getUserByToken(sid);
-  if (user) {
-    if (const auto& prevSession = user->getSession()) {
-      room = prevSession->room();
-      if (room) {
-        room->leave(prevSession);
-      }
-      prevSession->close();
-    }
-  } else {
-    user = m_users.create(sess->getRemoteEndpoint().address().to_v4().to_ulong());
-    ++m_registrations;
-    const auto& buffer = std::make_shared<Buffer>();
+  if (created) {
+    const auto& buffer = makeBuffer();
     OutgoingPacket::serializeGreeting(*buffer, user->getToken());
     sess->send(buffer);
+  } else if (const auto& prevSession = user->getSession()) {
+    room = prevSession->room();
+    if (room) {
+      room->leave(prevSession);
+    }
+    prevSession->close();
   }
 
   user->setSession(sess);
@@ -277,10 +380,78 @@ void Application::statistic()
   if (m_registrations > 0) {
     ss << "registrations value=" << m_registrations << "\n";
   }
+  SessionSendStats sendStats;
+  size_t laggingSessions = 0;
+  for (const auto& sess : m_sessions) {
+    auto stats = sess->getSendStats();
+    sendStats.queuedBytes = std::max(sendStats.queuedBytes, stats.queuedBytes);
+    sendStats.droppedFrames += stats.droppedFrames;
+    laggingSessions += stats.droppedFrames != 0;
+  }
+  if (!m_sessions.empty()) {
+    ss << "send maxQueuedBytes=" << sendStats.queuedBytes
+       << ",droppedFrames=" << sendStats.droppedFrames
+       << ",laggingSessions=" << laggingSessions << "\n";
+  }
+  {
+    auto stats = m_users.getStats();
+    ss << "users size=" << stats.size
+       << ",hits=" << stats.hits
+       << ",misses=" << stats.misses
+       << ",evictions=" << stats.evictions
+       << ",modified=" << stats.modified
+       << ",saved=" << stats.saved << "\n";
+  }
+  {
+    auto stats = m_tokenPool.getStats();
+    ss << "tokenpool size=" << stats.size
+       << ",popped=" << stats.popped
+       << ",empty=" << stats.empty
+       << ",inserted=" << stats.inserted << "\n";
+  }
+  {
+    auto stats = m_sessionLogger.getStats();
+    ss << "sessionlog queued=" << stats.queued
+       << ",written=" << stats.written
+       << ",dropped=" << stats.dropped
+       << ",flushes=" << stats.flushes
+       << ",lastFlush=" << stats.lastFlush.count()
+       << ",maxFlush=" << stats.maxFlush.count() << "\n";
+  }
   auto rooms = m_roomManager.size();
   if (rooms > 0) {
     ss << "rooms value=" << rooms << "\n";
   }
+  for (const auto& [id, stats] : m_roomManager.getGridmapStats()) {
+    ss << "gridmap,room=" << id
+       << " power=" << static_cast<int>(stats.power)
+       << ",cells=" << stats.cells
+       << ",meanSectorCells=" << stats.meanSectorCells
+       << ",maxSectorCells=" << stats.maxSectorCells
+       << ",meanSectorsPerCell=" << stats.meanSectorsPerCell;
+    for (size_t i = 0; i < stats.histogram.size(); ++i) {
+      ss << ",sectors" << (i ? 1 << (i - 1) : 0) << "=" << stats.histogram[i];
+    }
+    ss << "\n";
+  }
+  for (const auto& [id, pools] : m_roomManager.getPoolStats()) {
+    for (const auto& [type, stats] : pools) {
+      ss << "pool,room=" << id << ",type=" << type
+         << " size=" << stats.size
+         << ",capacity=" << stats.capacity
+         << ",highWater=" << stats.highWater << "\n";
+    }
+  }
+  for (const auto& [id, stats] : m_roomManager.getSyncStats()) {
+    ss << "sync,room=" << id
+       << " count=" << stats.count
+       << ",players=" << stats.players
+       << ",prepare=" << stats.prepare.count()
+       << ",params=" << stats.params.count()
+       << ",frames=" << stats.frames.count()
+       << ",cleanup=" << stats.cleanup.count()
+       << ",maxTotal=" << stats.maxTotal.count() << "\n";
+  }
   const auto& data = ss.str();
   if (!data.empty()) {
     Request request;
@@ -7,13 +7,17 @@
 #include "ListenerFwd.hpp"
 
 #include "Config.hpp"
+#include "GreetingService.hpp"
 #include "IOThreadPool.hpp"
 #include "IncomingPacket.hpp"
 #include "Listener.hpp"
 #include "MySQLConnectionPool.hpp"
+#include "MySQLUserStorage.hpp"
 #include "RoomManager.hpp"
 #include "Session.hpp"
+#include "SessionLogger.hpp"
 #include "Timer.hpp"
+#include "UserTokenPool.hpp"
 #include "UsersCache.hpp"
 
 #include <boost/asio.hpp>
@@ -38,6 +42,7 @@ private:
   void sessionMessageHandler(const SessionPtr& sess, beast::flat_buffer& buffer) const;
   void sessionOpenHandler(const SessionPtr& sess);
   void sessionCloseHandler(const SessionPtr& sess);
+  void writeSessions(std::span<const SessionRecord> records);
 
   void actionPing(const SessionPtr& sess, beast::flat_buffer& request);
   void actionGreeting(const SessionPtr& sess, beast::flat_buffer& request);
@@ -49,11 +54,15 @@ private:
   void actionChatMessage(const SessionPtr& sess, beast::flat_buffer& request);
   void actionWatch(const SessionPtr& sess, beast::flat_buffer& request);
 
+  void greet(const SessionPtr& sess, const UserPtr& user, bool created);
+
   void statistic();
+  void evictUsers();
 
 private:
   using MessageHandler = std::function<void(const SessionPtr& sess, beast::flat_buffer& ms)>;
   using MessageHandlers = std::unordered_map<uint8_t, MessageHandler>;
+  using WorkGuard = asio::executor_work_guard<asio::io_context::executor_type>;
 
   const MessageHandlers m_handlers {
     {IncomingPacket::Type::Ping,        std::bind(&Application::actionPing, this, _1, _2)},
@@ -69,16 +78,25 @@ private:
 
   mutable std::mutex            m_mutex;
   asio::io_context              m_ioContext;
+  asio::io_context              m_dbContext;
+  WorkGuard                     m_dbWorkGuard {m_dbContext.get_executor()};   // keeps the DB workers waiting for jobs
   asio::ip::tcp::socket         m_influxdb {m_ioContext};
   MySQLConnectionPool           m_mysqlConnectionPool;
+  SessionLogger                 m_sessionLogger {std::bind(&Application::writeSessions, this, _1)};
   Sessions                      m_sessions;
-  UsersCache                    m_users {m_mysqlConnectionPool};
+  MySQLUserStorage              m_userStorage {m_mysqlConnectionPool};
+  UserTokenPool                 m_tokenPool {m_dbContext.get_executor(), m_userStorage};
+  UsersCache                    m_users {m_userStorage, &m_tokenPool};
   RoomManager                   m_roomManager;
   IOThreadPool                  m_ioThreadPool {"IO worker", m_ioContext};
+  IOThreadPool                  m_dbThreadPool {"DB worker", m_dbContext};
+  GreetingService               m_greetingService {m_dbContext.get_executor(), m_users};
   std::vector<std::thread>      m_threads;
   std::string                   m_configFileName;
   config::Config                m_config;
   Timer                         m_statisticTimer;
+  Timer                         m_evictionTimer;
+  Timer                         m_saveTimer;
   std::size_t                   m_maxSessions {0};
   uint32_t                      m_registrations {0};
   ListenerPtr                   m_listener;
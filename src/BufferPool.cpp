@@ -0,0 +1,123 @@
+// file   : src/BufferPool.cpp
+// author : sba <bohdan.sadovyak@gmail.com>
+
+#include "BufferPool.hpp"
+
+#include <new>
+
+struct BufferPoolDeleter {
+  void operator()(Buffer* buffer) const { pool->release(buffer); }
+
+  BufferPool* pool;
+};
+
+// Allocates the shared_ptr control blocks from the pool's free list.
+template <typename T>
+class BufferPoolAllocator {
+public:
+  using value_type = T;
+
+  explicit BufferPoolAllocator(BufferPool* pool) : m_pool(pool) {}
+
+  template <typename U>
+  BufferPoolAllocator(const BufferPoolAllocator<U>& other) : m_pool(other.m_pool) {}
+
+  T* allocate(size_t n)
+  {
+    static_assert(sizeof(T) <= BufferPool::BlockSize && alignof(T) <= alignof(std::max_align_t));
+    if (n != 1) {
+      throw std::bad_alloc();
+    }
+    return static_cast<T*>(m_pool->allocateBlock());
+  }
+
+  void deallocate(T* block, size_t) { m_pool->releaseBlock(block); }
+
+  template <typename U>
+  bool operator==(const BufferPoolAllocator<U>& other) const { return m_pool == other.m_pool; }
+
+private:
+  template <typename U>
+  friend class BufferPoolAllocator;
+
+  BufferPool* m_pool;
+};
+
+BufferPool& BufferPool::instance()
+{
+  // never destroyed: sessions may still release buffers while static objects are torn down
+  static auto* pool = new BufferPool();
+  return *pool;
+}
+
+BufferPool::~BufferPool()
+{
+  for (auto* buffer : m_buffers) {
+    delete buffer;
+  }
+  for (auto* block : m_blocks) {
+    ::operator delete(block);
+  }
+}
+
+BufferPtr BufferPool::acquire(size_t capacity)
+{
+  Buffer* buffer = nullptr;
+  {
+    std::lock_guard lock(m_mutex);
+    ++m_stats.acquired;
+    if (!m_buffers.empty()) {
+      buffer = m_buffers.back();
+      m_buffers.pop_back();
+    }
+  }
+  if (!buffer) {
+    buffer = new Buffer();
+    std::lock_guard lock(m_mutex);
+    ++m_stats.allocated;
+  }
+  // if the control block cannot be allocated, shared_ptr hands the buffer to the deleter
+  BufferPtr result(buffer, BufferPoolDeleter{this}, BufferPoolAllocator<char>(this));
+  result->reserve(capacity);
+  return result;
+}
+
+BufferPoolStats BufferPool::getStats() const
+{
+  std::lock_guard lock(m_mutex);
+  auto stats = m_stats;
+  stats.idle = m_buffers.size();
+  return stats;
+}
+
+void BufferPool::release(Buffer* buffer)
+{
+  buffer->clear();
+  if (buffer->capacity() <= MaxCapacity) {
+    std::lock_guard lock(m_mutex);
+    if (m_buffers.size() < MaxIdle) {
+      m_buffers.push_back(buffer);
+      return;
+    }
+  }
+  delete buffer;
+}
+
+void* BufferPool::allocateBlock()
+{
+  {
+    std::lock_guard lock(m_mutex);
+    if (!m_blocks.empty()) {
+      auto* block = m_blocks.back();
+      m_blocks.pop_back();
+      return block;
+    }
+  }
+  return ::operator new(BlockSize);
+}
+
+void BufferPool::releaseBlock(void* block)
+{
+  std::lock_guard lock(m_mutex);
+  m_blocks.push_back(block);
+}
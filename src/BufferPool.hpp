@@ -0,0 +1,63 @@
+// file   : src/BufferPool.hpp
+// author : sba <bohdan.sadovyak@gmail.com>
+
+#ifndef THEGAME_BUFFER_POOL_HPP
+#define THEGAME_BUFFER_POOL_HPP
+
+#include "types.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+struct BufferPoolStats {
+  size_t  acquired {0};                 // buffers handed out
+  size_t  allocated {0};                // of them, new ones
+  size_t  idle {0};                     // buffers waiting in the pool
+};
+
+// Recycles outgoing packet buffers. The last owner of a buffer, usually a session whose write completed on an IO
+// thread, returns it to the pool empty but with its capacity; the shared_ptr control blocks are kept on a free list
+// too. Once the pool has warmed up, acquiring and releasing a buffer does not touch the global allocator. Thread safe.
+class BufferPool {
+public:
+  static constexpr size_t MaxIdle {4096};
+  static constexpr size_t MaxCapacity {256 * 1024};   // larger buffers are freed instead of kept
+
+  // The process-wide pool: buffers outlive the rooms and sessions that send them.
+  static BufferPool& instance();
+
+  BufferPool() = default;
+  BufferPool(const BufferPool&) = delete;
+  BufferPool& operator=(const BufferPool&) = delete;
+  ~BufferPool();
+
+  // An empty buffer with room for at least `capacity` bytes.
+  BufferPtr acquire(size_t capacity = 0);
+
+  [[nodiscard]] BufferPoolStats getStats() const;
+
+private:
+  template <typename T>
+  friend class BufferPoolAllocator;
+  friend struct BufferPoolDeleter;
+
+  static constexpr size_t BlockSize {64};     // fits the control block of a shared_ptr with a deleter and allocator
+
+  void release(Buffer* buffer);
+  void* allocateBlock();
+  void releaseBlock(void* block);
+
+  mutable std::mutex    m_mutex;
+  std::vector<Buffer*>  m_buffers;
+  std::vector<void*>    m_blocks;
+  BufferPoolStats       m_stats;
+};
+
+inline BufferPtr makeBuffer(size_t capacity = 0)
+{
+  return BufferPool::instance().acquire(capacity);
+}
+
+#endif /* THEGAME_BUFFER_POOL_HPP */
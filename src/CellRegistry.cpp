@@ -0,0 +1,73 @@
+// file   : src/CellRegistry.cpp
+// author : sba <bohdan.sadovyak@gmail.com>
+
+#include "CellRegistry.hpp"
+
+#include "entity/Cell.hpp"
+
+#include <stdexcept>
+
+CellRegistry::CellRegistry(uint8_t index)
+  : m_member(static_cast<uint8_t>(1u << (2 * index)))
+  , m_listed(static_cast<uint8_t>(2u << (2 * index)))
+{
+  if (index >= MaxRegistries) {
+    throw std::invalid_argument("Invalid cell registry index");
+  }
+}
+
+bool CellRegistry::insert(Cell* cell)
+{
+  if (cell->registries & m_member) {
+    return false;
+  }
+  cell->registries |= m_member;
+  ++m_size;
+  if (!(cell->registries & m_listed)) {
+    cell->registries |= m_listed;
+    m_cells.push_back(cell);
+  }
+  return true;
+}
+
+void CellRegistry::erase(Cell* cell)
+{
+  if (cell->registries & m_member) {
+    cell->registries &= ~m_member;
+    --m_size;
+  }
+}
+
+bool CellRegistry::contains(const Cell* cell) const
+{
+  return cell->registries & m_member;
+}
+
+const std::vector<Cell*>& CellRegistry::cells()
+{
+  compact();
+  return m_cells;
+}
+
+void CellRegistry::compact()
+{
+  if (m_size == m_cells.size()) {
+    return;
+  }
+  std::erase_if(m_cells, [this](Cell* cell) {
+    if (cell->registries & m_member) {
+      return false;
+    }
+    cell->registries &= ~m_listed;
+    return true;
+  });
+}
+
+void CellRegistry::clear()
+{
+  for (auto* cell : m_cells) {
+    cell->registries &= ~(m_member | m_listed);
+  }
+  m_cells.clear();
+  m_size = 0;
+}
@@ -0,0 +1,42 @@
+// file   : src/CellRegistry.hpp
+// author : sba <bohdan.sadovyak@gmail.com>
+
+#ifndef THEGAME_CELL_REGISTRY_HPP
+#define THEGAME_CELL_REGISTRY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Cell;
+
+// Set of cells stored as a plain vector. Membership lives in two bits of Cell::registries (member and listed), so
+// insert, erase and contains are O(1) without hashing and iteration is contiguous. erase() only clears the member
+// bit and leaves a hole in the vector that compact() removes; cells() compacts before handing the vector out.
+// A cell must not be destroyed while it is listed: erase() it and compact() (or clear()) the registry first.
+class CellRegistry {
+public:
+  static constexpr uint8_t MaxRegistries {4};
+
+  // index selects the bits of Cell::registries used by this registry, each registry of a cell needs its own
+  explicit CellRegistry(uint8_t index);
+
+  bool insert(Cell* cell);
+  void erase(Cell* cell);
+  [[nodiscard]] bool contains(const Cell* cell) const;
+
+  const std::vector<Cell*>& cells();
+  void compact();
+  void clear();
+
+  [[nodiscard]] size_t size() const { return m_size; }
+  [[nodiscard]] bool empty() const { return m_size == 0; }
+
+private:
+  std::vector<Cell*>  m_cells;
+  size_t              m_size {0};
+  uint8_t             m_member;
+  uint8_t             m_listed;
+};
+
+#endif /* THEGAME_CELL_REGISTRY_HPP */
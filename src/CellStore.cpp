@@ -0,0 +1,139 @@
+// file   : src/CellStore.cpp
+// author : sba <bohdan.sadovyak@gmail.com>
+
+#include "CellStore.hpp"
+
+#include "entity/Cell.hpp"
+
+#include <cmath>
+
+namespace {
+
+// Same arithmetic as Vec2D::direction(), inlined for the loops below.
+Vec2D direction(const Vec2D& v)
+{
+  auto length = std::sqrt(v.x * v.x + v.y * v.y);
+  return length > 0 ? Vec2D(v.x / length, v.y / length) : v;
+}
+
+} // namespace
+
+CellHandle CellStore::add(Cell* cell)
+{
+  uint32_t index;
+  if (m_freeSlots.empty()) {
+    index = static_cast<uint32_t>(m_slots.size());
+    m_slots.emplace_back();
+  } else {
+    index = m_freeSlots.back();
+    m_freeSlots.pop_back();
+  }
+  auto& slot = m_slots[index];
+  slot.cell = cell;
+  slot.row = static_cast<uint32_t>(m_cells.size());
+  m_cells.push_back(cell);
+  cell->handle = {index, slot.generation};
+  return cell->handle;
+}
+
+void CellStore::remove(Cell* cell)
+{
+  stopMotion(cell);
+  auto& slot = m_slots[cell->handle.index];
+  Cell* last = m_cells.back();
+  m_cells[slot.row] = last;
+  m_slots[last->handle.index].row = slot.row;
+  m_cells.pop_back();
+  slot.cell = nullptr;
+  slot.row = NoRow;
+  ++slot.generation;
+  m_freeSlots.push_back(cell->handle.index);
+  cell->handle = {};
+}
+
+Cell* CellStore::get(CellHandle handle) const
+{
+  if (handle.index >= m_slots.size()) {
+    return nullptr;
+  }
+  const auto& slot = m_slots[handle.index];
+  return slot.generation == handle.generation ? slot.cell : nullptr;
+}
+
+void CellStore::startMotion(Cell* cell)
+{
+  auto& slot = m_slots[cell->handle.index];
+  if (slot.motionRow != NoRow) {
+    return;
+  }
+  slot.motionRow = static_cast<uint32_t>(m_moving.size());
+  m_moving.push_back(cell);
+}
+
+void CellStore::stopMotion(Cell* cell)
+{
+  auto& slot = m_slots[cell->handle.index];
+  if (slot.motionRow == NoRow) {
+    return;
+  }
+  Cell* last = m_moving.back();
+  m_moving[slot.motionRow] = last;
+  m_slots[last->handle.index].motionRow = slot.motionRow;
+  m_moving.pop_back();
+  slot.motionRow = NoRow;
+}
+
+bool CellStore::isMoving(const Cell* cell) const
+{
+  return !cell->handle.empty() && m_slots[cell->handle.index].motionRow != NoRow;
+}
+
+void CellStore::integrate(double dt)
+{
+  const auto count = m_moving.size();
+  m_position.resize(count);
+  m_velocity.resize(count);
+  m_force.resize(count);
+  m_mass.resize(count);
+  m_resistance.resize(count);
+  m_forced.resize(count);
+  m_stopped.resize(count);
+
+  for (size_t i = 0; i < count; ++i) {
+    const Cell& cell = *m_moving[i];
+    m_position[i] = cell.position;
+    m_velocity[i] = cell.velocity;
+    m_force[i] = cell.force;
+    m_mass[i] = cell.mass;
+    m_resistance[i] = cell.radius * cell.resistanceRatio;
+  }
+
+  for (size_t i = 0; i < count; ++i) {
+    auto dir = direction(m_velocity[i]);
+    m_force[i].x -= dir.x * m_resistance[i];
+    m_force[i].y -= dir.y * m_resistance[i];
+    m_forced[i] = m_force[i].x != 0 || m_force[i].y != 0;
+  }
+
+  const auto step = static_cast<float>(dt);
+  for (size_t i = 0; i < count; ++i) {
+    auto prevDir = direction(m_velocity[i]);
+    m_velocity[i].x += m_force[i].x / m_mass[i] * step;
+    m_velocity[i].y += m_force[i].y / m_mass[i] * step;
+    auto dir = direction(m_velocity[i]);
+    m_stopped[i] = std::fabs(1 + (dir.x * prevDir.x + dir.y * prevDir.y)) <= 0.01;
+    if (m_stopped[i]) {
+      m_velocity[i].zero();
+    } else {
+      m_position[i].x += m_velocity[i].x * step;
+      m_position[i].y += m_velocity[i].y * step;
+    }
+  }
+
+  for (size_t i = 0; i < count; ++i) {
+    Cell& cell = *m_moving[i];
+    cell.position = m_position[i];
+    cell.velocity = m_velocity[i];
+    cell.force.zero();
+  }
+}
@@ -0,0 +1,84 @@
+// file   : src/CellStore.hpp
+// author : sba <bohdan.sadovyak@gmail.com>
+
+#ifndef THEGAME_CELL_STORE_HPP
+#define THEGAME_CELL_STORE_HPP
+
+#include "geometry/Vec2D.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+class Cell;
+
+// Weak reference to a cell in a CellStore. The generation changes every time the slot is reused, so a handle kept
+// after its cell has been removed never resolves to another cell.
+struct CellHandle {
+  static constexpr uint32_t None {std::numeric_limits<uint32_t>::max()};
+
+  [[nodiscard]] bool empty() const { return index == None; }
+
+  bool operator==(const CellHandle& other) const = default;
+
+  uint32_t  index {None};
+  uint32_t  generation {0};
+};
+
+// Registry of the cells of a room. Live cells are kept in a dense array for iteration and addressed by generational
+// handles. Moving cells additionally get a row in the motion table: packed arrays of the kinematic state, loaded from
+// the cells and written back by integrate(), so the physics step runs as plain loops over contiguous memory.
+class CellStore {
+public:
+  using Cells = std::vector<Cell*>;
+
+  CellHandle add(Cell* cell);
+  void remove(Cell* cell);
+  [[nodiscard]] Cell* get(CellHandle handle) const;
+
+  void startMotion(Cell* cell);
+  void stopMotion(Cell* cell);
+  [[nodiscard]] bool isMoving(const Cell* cell) const;
+
+  // Applies the resistance force to every moving cell and integrates its motion over dt, in the order of moving().
+  // Afterwards forced(row) tells whether the cell had a non-zero force and stopped(row) whether its velocity reversed
+  // and was reset. The motion table itself is left as is: stopping cells is up to the caller.
+  void integrate(double dt);
+
+  [[nodiscard]] const Cells& cells() const { return m_cells; }
+  [[nodiscard]] const Cells& moving() const { return m_moving; }
+  [[nodiscard]] bool forced(size_t row) const { return m_forced[row]; }
+  [[nodiscard]] bool stopped(size_t row) const { return m_stopped[row]; }
+  [[nodiscard]] size_t size() const { return m_cells.size(); }
+  [[nodiscard]] bool empty() const { return m_cells.empty(); }
+
+  Cells::const_iterator begin() const { return m_cells.begin(); }
+  Cells::const_iterator end() const { return m_cells.end(); }
+
+private:
+  static constexpr uint32_t NoRow {std::numeric_limits<uint32_t>::max()};
+
+  struct Slot {
+    Cell*     cell {nullptr};
+    uint32_t  generation {0};
+    uint32_t  row {NoRow};                // index in m_cells
+    uint32_t  motionRow {NoRow};          // index in the motion table
+  };
+
+  std::vector<Slot>     m_slots;
+  std::vector<uint32_t> m_freeSlots;
+  Cells                 m_cells;
+
+  // motion table
+  Cells                 m_moving;
+  std::vector<Vec2D>    m_position;
+  std::vector<Vec2D>    m_velocity;
+  std::vector<Vec2D>    m_force;
+  std::vector<float>    m_mass;
+  std::vector<float>    m_resistance;       // radius * resistanceRatio
+  std::vector<uint8_t>  m_forced;
+  std::vector<uint8_t>  m_stopped;
+};
+
+#endif /* THEGAME_CELL_STORE_HPP */
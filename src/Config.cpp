@@ -42,6 +42,47 @@ struct from<Duration>
   }
 };
 
+template <>
+struct from<config::Deflate>
+{
+  static auto from_toml(const value& v)
+  {
+    config::Deflate result{};
+
+    result.enabled            = find_or<bool>(v, "enabled", result.enabled);
+    result.level              = find_or<int>(v, "level", result.level);
+    result.windowBits         = find_or<int>(v, "windowBits", result.windowBits);
+    result.memLevel           = find_or<int>(v, "memLevel", result.memLevel);
+    result.noContextTakeover  = find_or<bool>(v, "noContextTakeover", result.noContextTakeover);
+    result.broadcastThreshold = find_or<uint32_t>(v, "broadcastThreshold", result.broadcastThreshold);
+    if (result.level < 0 || result.level > 9) {
+      throw std::runtime_error("server.deflate.level should be in 0..9");
+    }
+    if (result.windowBits < 9 || result.windowBits > 15) {
+      throw std::runtime_error("server.deflate.windowBits should be in 9..15");
+    }
+    if (result.memLevel < 1 || result.memLevel > 9) {
+      throw std::runtime_error("server.deflate.memLevel should be in 1..9");
+    }
+
+    return result;
+  }
+};
+
+template <>
+struct from<config::SendQueue>
+{
+  static auto from_toml(const value& v)
+  {
+    config::SendQueue result{};
+
+    result.maxBytes     = find_or<uint32_t>(v, "maxBytes", result.maxBytes);
+    result.maxMessages  = find_or<uint32_t>(v, "maxMessages", result.maxMessages);
+
+    return result;
+  }
+};
+
 template <>
 struct from<config::Server>
 {
@@ -53,6 +94,55 @@ struct from<config::Server>
     const auto port = find<uint16_t>(v, "port");
     result.address = asio::ip::tcp::endpoint(asio::ip::address::from_string(host), port);
     result.numThreads = find<uint32_t>(v, "numThreads");
+    result.deflate = v.contains("deflate") ? find<config::Deflate>(v, "deflate") : config::Deflate{};
+    result.sendQueue = v.contains("sendQueue") ? find<config::SendQueue>(v, "sendQueue") : config::SendQueue{};
+
+    return result;
+  }
+};
+
+template <>
+struct from<config::TokenPool>
+{
+  static auto from_toml(const value& v)
+  {
+    config::TokenPool result{};
+
+    result.capacity   = find_or<uint32_t>(v, "capacity", result.capacity);
+    result.lowWater   = find_or<uint32_t>(v, "lowWater", result.lowWater);
+    result.batchSize  = find_or<uint32_t>(v, "batchSize", result.batchSize);
+    if (result.capacity && result.lowWater >= result.capacity) {
+      throw std::runtime_error("users.tokenPool.lowWater should be less than capacity");
+    }
+    if (result.batchSize == 0) {
+      throw std::runtime_error("users.tokenPool.batchSize should be positive");
+    }
+
+    return result;
+  }
+};
+
+template <>
+struct from<config::Users>
+{
+  static auto from_toml(const value& v)
+  {
+    config::Users result{};
+
+    result.ttl              = find_or<Duration>(v, "ttl", result.ttl);
+    result.evictionInterval = find_or<Duration>(v, "evictionInterval", result.evictionInterval);
+    result.saveInterval     = find_or<Duration>(v, "saveInterval", result.saveInterval);
+    result.saveBatchSize    = find_or<uint32_t>(v, "saveBatchSize", result.saveBatchSize);
+    result.tokenPool = v.contains("tokenPool") ? find<config::TokenPool>(v, "tokenPool") : config::TokenPool{};
+    if (result.evictionInterval <= Duration::zero()) {
+      throw std::runtime_error("users.evictionInterval should be positive");
+    }
+    if (result.saveInterval <= Duration::zero()) {
+      throw std::runtime_error("users.saveInterval should be positive");
+    }
+    if (result.saveBatchSize == 0) {
+      throw std::runtime_error("users.saveBatchSize should be positive");
+    }
 
     return result;
   }
@@ -76,6 +166,27 @@ struct from<config::InfluxDb>
   }
 };
 
+template <>
+struct from<config::SessionLog>
+{
+  static auto from_toml(const value& v)
+  {
+    config::SessionLog result{};
+
+    result.flushInterval  = find_or<Duration>(v, "flushInterval", result.flushInterval);
+    result.batchSize      = find_or<uint32_t>(v, "batchSize", result.batchSize);
+    result.queueSize      = find_or<uint32_t>(v, "queueSize", result.queueSize);
+    if (result.flushInterval <= Duration::zero()) {
+      throw std::runtime_error("mysql.sessionLog.flushInterval should be positive");
+    }
+    if (result.batchSize == 0) {
+      throw std::runtime_error("mysql.sessionLog.batchSize should be positive");
+    }
+
+    return result;
+  }
+};
+
 template <>
 struct from<config::MySql>
 {
@@ -90,6 +201,11 @@ struct from<config::MySql>
     result.password     = find<std::string>(v, "password");
     result.charset      = find<std::string>(v, "charset");
     result.maxIdleTime  = find<uint>(v, "maxIdleTime");
+    result.numThreads   = find_or<uint32_t>(v, "numThreads", result.numThreads);
+    if (result.numThreads == 0) {
+      throw std::runtime_error("mysql.numThreads should be positive");
+    }
+    result.sessionLog   = v.contains("sessionLog") ? find<config::SessionLog>(v, "sessionLog") : config::SessionLog{};
 
     return result;
   }
@@ -123,6 +239,7 @@ struct from<config::Player>
     result.deflationRatio         = find<float>(v, "deflationRatio");
     result.annihilationThreshold  = find<Duration>(v, "annihilationThreshold");
     result.pointerForceRatio      = find<float>(v, "pointerForceRatio");
+    result.deltaFrames            = find_or<bool>(v, "deltaFrames", false);
 
     return result;
   }
@@ -257,6 +374,45 @@ struct from<config::Generator>
   }
 };
 
+template <>
+struct from<config::Gridmap>
+{
+  static auto from_toml(value& v)
+  {
+    config::Gridmap result{};
+
+    const auto index = find_or<std::string>(v, "index", "grid");
+    if (index == "grid") {
+      result.index = config::Gridmap::Index::Grid;
+    } else if (index == "quadtree") {
+      result.index = config::Gridmap::Index::Quadtree;
+    } else {
+      throw std::runtime_error("room.gridmap.index should be 'grid' or 'quadtree'");
+    }
+    result.power        = find_or<uint8_t>(v, "power", result.power);
+    result.autoTune     = find_or<bool>(v, "autoTune", false);
+    result.minPower     = find_or<uint8_t>(v, "minPower", result.minPower);
+    result.maxPower     = find_or<uint8_t>(v, "maxPower", result.maxPower);
+    result.tuneInterval = find_or<Duration>(v, "tuneInterval", result.tuneInterval);
+
+    if (result.minPower < 4 || result.maxPower > 14 || result.minPower > result.maxPower) {
+      throw std::runtime_error("room.gridmap: minPower..maxPower should be within 4..14");
+    }
+    if (result.autoTune) {
+      if (result.power < result.minPower || result.power > result.maxPower) {
+        throw std::runtime_error("room.gridmap.power should be within minPower..maxPower");
+      }
+    } else if (result.power < 4 || result.power > 14) {
+      throw std::runtime_error("room.gridmap.power should be within 4..14");
+    }
+    if (result.tuneInterval == Duration::zero()) {
+      throw std::runtime_error("room.gridmap.tuneInterval should be > 0");
+    }
+
+    return result;
+  }
+};
+
 template <>
 struct from<config::Room>
 {
@@ -268,6 +424,7 @@ struct from<config::Room>
     if (result.numThreads < 1) {
       throw std::runtime_error("room.numThreads should be > 0");
     }
+    result.syncWorkers = find_or<uint32_t>(v, "syncWorkers", result.numThreads);
 
     result.updateInterval = find<Duration>(v, "updateInterval");
     if (result.updateInterval == Duration::zero()) {
@@ -275,6 +432,10 @@ struct from<config::Room>
     }
 
     result.syncInterval = find<Duration>(v, "syncInterval");
+    result.deadReckoningThreshold = find_or<float>(v, "deadReckoningThreshold", 0);
+    if (result.deadReckoningThreshold < 0) {
+      throw std::runtime_error("room.deadReckoningThreshold should be >= 0");
+    }
 
     result.spawnPosTryCount             = find<uint32_t>(v, "spawnPosTryCount");
     result.checkExpirableCellsInterval  = find<Duration>(v, "checkExpirableCellsInterval");
@@ -305,6 +466,7 @@ struct from<config::Room>
     result.phage      = find<config::Phage>(v, "phage");
     result.mother     = find<config::Mother>(v, "mother");
     result.generator  = find<config::Generator>(v, "generator");
+    result.gridmap    = v.contains("gridmap") ? find<config::Gridmap>(v, "gridmap") : config::Gridmap{};
 
     result.simulationInterval = std::chrono::duration_cast<std::chrono::duration<double>>(result.updateInterval).count();
     result.cellMinRadius = result.cellRadiusRatio * sqrt(result.cellMinMass / M_PI);
@@ -326,6 +488,7 @@ void Config::load(const std::string& filename)
 
   server    = toml::find<config::Server>(data, "server");
   mysql     = toml::find<config::MySql>(data, "mysql");
+  users     = data.contains("users") ? toml::find<config::Users>(data, "users") : config::Users{};
   influxdb  = toml::find<config::InfluxDb>(data, "influxdb");
   room      = toml::find<config::Room>(data, "room");
 }
@@ -12,9 +12,33 @@
 
 namespace config {
 
+struct Deflate {
+  uint32_t  broadcastThreshold {0};     // room broadcasts this long or longer are sent deflated once, 0: never
+  int       level {6};
+  int       windowBits {15};
+  int       memLevel {8};
+  bool      enabled {false};            // negotiate websocket permessage-deflate
+  bool      noContextTakeover {true};   // compress every message on its own, saves the window memory per session
+};
+
+struct SendQueue {
+  // A session over a limit is behind and drops frames, then gets a full one flagged Reset: needs a client that reads
+  // the flag, so both limits are off (0) by default.
+  uint32_t  maxBytes {0};               // queued bytes
+  uint32_t  maxMessages {0};            // queued packets
+};
+
 struct Server {
   boost::asio::ip::tcp::endpoint address;
-  uint32_t numThreads {0};
+  uint32_t  numThreads {0};
+  Deflate   deflate;
+  SendQueue sendQueue;
+};
+
+struct SessionLog {
+  Duration  flushInterval {1s};
+  uint32_t  batchSize {500};            // rows per INSERT; a full batch is written without waiting for the interval
+  uint32_t  queueSize {100000};         // sessions closing while this many wait are not logged, 0: no limit
 };
 
 struct MySql {
@@ -25,6 +49,22 @@ struct MySql {
   std::string charset;
   uint        port {0};
   uint        maxIdleTime {0};
+  uint32_t    numThreads {2};           // DB workers: user lookups and registrations
+  SessionLog  sessionLog;
+};
+
+struct TokenPool {
+  uint32_t  capacity {1000};            // users registered ahead of time, 0: register each one on its own
+  uint32_t  lowWater {250};             // refill when no more than this many are left
+  uint32_t  batchSize {100};            // rows per INSERT
+};
+
+struct Users {
+  Duration  ttl {1h};                   // cached users not looked up for this long and offline are dropped
+  Duration  evictionInterval {1min};
+  Duration  saveInterval {1min};        // modified users are written this often
+  uint32_t  saveBatchSize {500};        // users per UPDATE statement
+  TokenPool tokenPool;
 };
 
 struct InfluxDb {
@@ -49,6 +89,7 @@ struct Player {
   float     deflationRatio {0};
   Duration  annihilationThreshold;
   float     pointerForceRatio {0};
+  bool      deltaFrames {false};        // send cells as DeltaCells (changed fields only) instead of SyncCells
 };
 
 struct Bot {
@@ -119,6 +160,17 @@ struct Generator {
   Item mother;
 };
 
+struct Gridmap {
+  enum class Index { Grid, Quadtree };
+
+  Index     index {Index::Grid};
+  uint8_t   power {9};                  // sector size is 2^power
+  uint8_t   minPower {7};               // auto-tuning bounds
+  uint8_t   maxPower {11};
+  Duration  tuneInterval {5s};          // stats sampling (and auto-tuning) period
+  bool      autoTune {false};
+};
+
 struct Room {
   using BotNames = std::vector<std::string>;
 
@@ -131,12 +183,15 @@ struct Room {
   Phage     phage;
   Mother    mother;
   Generator generator;
+  Gridmap   gridmap;
 
   float     eps {0.01};
 
   uint32_t  numThreads {0};
+  uint32_t  syncWorkers {1};            // threads building the frames of a sync, the room's own included
   Duration  updateInterval;
   Duration  syncInterval;
+  float     deadReckoningThreshold {0}; // resend a moving cell once the clients' extrapolation is off by more, 0: always
 
   uint32_t  spawnPosTryCount {0};
 
@@ -175,6 +230,7 @@ public:
 
   Server    server;
   MySql     mysql;
+  Users     users;
   InfluxDb  influxdb;
   Room      room;
 };
@@ -0,0 +1,33 @@
+// file   : src/Deflater.cpp
+// author : sba <bohdan.sadovyak@gmail.com>
+
+#include "Deflater.hpp"
+
+#include <stdexcept>
+
+namespace zlib = boost::beast::zlib;
+
+Deflater::Deflater(int level, int windowBits, int memLevel)
+{
+  m_stream.reset(level, windowBits, memLevel, zlib::Strategy::normal);
+}
+
+void Deflater::compress(const char* data, size_t size, Buffer& out)
+{
+  auto offset = out.size();
+  out.resize(offset + m_stream.upper_bound(size));
+
+  zlib::z_params params;
+  params.next_in = data;
+  params.avail_in = size;
+  params.next_out = out.data() + offset;
+  params.avail_out = out.size() - offset;
+  boost::beast::error_code ec;
+  m_stream.write(params, zlib::Flush::finish, ec);
+  m_stream.reset();
+  if (ec != zlib::error::end_of_stream) {
+    out.resize(offset);
+    throw std::runtime_error("Deflate failed: " + ec.message());
+  }
+  out.resize(out.size() - params.avail_out);
+}
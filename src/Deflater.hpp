@@ -0,0 +1,26 @@
+// file   : src/Deflater.hpp
+// author : sba <bohdan.sadovyak@gmail.com>
+
+#ifndef THEGAME_DEFLATER_HPP
+#define THEGAME_DEFLATER_HPP
+
+#include "types.hpp"
+
+#include <boost/beast/zlib/deflate_stream.hpp>
+
+#include <cstddef>
+
+// Raw deflate (RFC 1951, no zlib header) of whole messages, with Beast's zlib so the server needs no extra library.
+// The stream's buffers are kept between messages; each message is compressed on its own. Not thread safe.
+class Deflater {
+public:
+  explicit Deflater(int level = 6, int windowBits = 15, int memLevel = 8);
+
+  // Appends the compressed data to `out`.
+  void compress(const char* data, size_t size, Buffer& out);
+
+private:
+  boost::beast::zlib::deflate_stream  m_stream;
+};
+
+#endif /* THEGAME_DEFLATER_HPP */
@@ -0,0 +1,111 @@
+// file   : src/DeltaEncoder.cpp
+// author : sba <bohdan.sadovyak@gmail.com>
+
+#include "DeltaEncoder.hpp"
+
+#include "Player.hpp"
+#include "serialization.hpp"
+
+#include "entity/Cell.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+int16_t toInt16(float value)
+{
+  constexpr auto min = static_cast<float>(std::numeric_limits<int16_t>::min());
+  constexpr auto max = static_cast<float>(std::numeric_limits<int16_t>::max());
+  return static_cast<int16_t>(std::clamp(std::round(value), min, max));
+}
+
+} // namespace
+
+float DeltaEncoder::getStep(uint32_t width, uint32_t height)
+{
+  return 2.0f * static_cast<float>(std::max(width, height)) / std::numeric_limits<uint16_t>::max();
+}
+
+DeltaEncoder::DeltaEncoder(float step) : m_step(step) {}
+
+void DeltaEncoder::begin(Buffer& buffer, const Vec2D& origin)
+{
+  m_originX = quantize(origin.x);
+  m_originY = quantize(origin.y);
+  serialize(buffer, m_step);
+  serialize(buffer, m_originX);
+  serialize(buffer, m_originY);
+}
+
+bool DeltaEncoder::encode(Buffer& buffer, const Cell& cell, ClientCell& known, bool full) const
+{
+  ClientCell current {
+    .x = quantize(cell.position.x),
+    .y = quantize(cell.position.y),
+    .mass = static_cast<uint32_t>(cell.mass),
+    .radius = static_cast<uint16_t>(cell.radius),
+    .color = cell.color,
+    .vx = toInt16(cell.velocity.x),
+    .vy = toInt16(cell.velocity.y)
+  };
+  auto moving = current.vx != 0 || current.vy != 0;
+
+  uint8_t fields = 0;
+  if (full) {
+    fields = Full | Position | Mass | Radius | Color;
+    if (cell.player && cell.type == Cell::typeAvatar) {
+      fields |= PlayerId;
+    }
+    if (moving) {
+      fields |= Velocity;
+    }
+  } else {
+    fields |= Position * (current.x != known.x || current.y != known.y);
+    fields |= Mass * (current.mass != known.mass);
+    fields |= Radius * (current.radius != known.radius);
+    fields |= Color * (current.color != known.color);
+    fields |= Velocity * (current.vx != known.vx || current.vy != known.vy);
+    if (!fields) {
+      return false;
+    }
+  }
+  known = current;
+
+  BufferWriter writer(buffer, MaxRecordSize);
+  writer.writeVarint(cell.id);
+  writer.write(fields);
+  if (fields & Full) {
+    writer.write(static_cast<uint8_t>(cell.type | Cell::isNew * cell.newly | Cell::isMoving * moving));
+  }
+  if (fields & Position) {
+    auto offset = [](int32_t value, int32_t origin) {
+      return static_cast<uint16_t>(std::clamp(value - origin + 32768, 0, 65535));
+    };
+    writer.write(offset(current.x, m_originX));
+    writer.write(offset(current.y, m_originY));
+  }
+  if (fields & Mass) {
+    writer.writeVarint(current.mass);
+  }
+  if (fields & Radius) {
+    writer.writeVarint(current.radius);
+  }
+  if (fields & Color) {
+    writer.write(current.color);
+  }
+  if (fields & PlayerId) {
+    writer.writeVarint(cell.player->getId());
+  }
+  if (fields & Velocity) {
+    writer.write(current.vx);
+    writer.write(current.vy);
+  }
+  return true;
+}
+
+int32_t DeltaEncoder::quantize(float value) const
+{
+  return static_cast<int32_t>(std::lround(value / m_step));
+}
@@ -0,0 +1,74 @@
+// file   : src/DeltaEncoder.hpp
+// author : sba <bohdan.sadovyak@gmail.com>
+
+#ifndef THEGAME_DELTA_ENCODER_HPP
+#define THEGAME_DELTA_ENCODER_HPP
+
+#include "types.hpp"
+
+#include "geometry/Vec2D.hpp"
+
+#include <cstdint>
+#include <unordered_map>
+
+class Cell;
+
+// A cell as its client last received it, in the units it was sent in.
+struct ClientCell {
+  int32_t   x {0};                      // position in quantization steps
+  int32_t   y {0};
+  uint32_t  mass {0};
+  uint16_t  radius {0};
+  uint8_t   color {0};
+  int16_t   vx {0};                     // velocity in units per second
+  int16_t   vy {0};
+};
+
+using ClientCells = std::unordered_map<uint32_t, ClientCell>;
+
+// Writes the DeltaCells section of a Frame: only the fields of a cell that changed since the client last received
+// it. The section starts with the quantization step (float) and the origin (int32 x, y, in steps) the positions are
+// relative to, followed by the uint16 count and the records:
+//
+//   varint id, uint8 fields,
+//   [Full]     uint8 type with the Cell::isNew / isMoving flags, the client creates the cell,
+//   [Position] uint16 x, y: position / step - origin + 32768,
+//   [Mass]     varint, [Radius] varint, [Color] uint8, [PlayerId] varint (avatars),
+//   [Velocity] int16 x, y in units per second, zero when the cell stopped.
+//
+// A full record carries all fields, Velocity only when the cell moves.
+class DeltaEncoder {
+public:
+  enum Fields : uint8_t {
+    Position = 1,
+    Mass = 2,
+    Radius = 4,
+    Color = 8,
+    PlayerId = 16,
+    Velocity = 32,
+    Full = 128
+  };
+
+  // The step that lets a uint16 offset reach any point of a width x height map from any origin inside it.
+  static float getStep(uint32_t width, uint32_t height);
+
+  explicit DeltaEncoder(float step);
+
+  // Writes the section header up to the count; the origin is rounded to the step.
+  void begin(Buffer& buffer, const Vec2D& origin);
+
+  // Writes the record of the cell for a client that knows it as `known` (anything if `full`), and updates `known`.
+  // Returns false and writes nothing if nothing the client sees has changed.
+  bool encode(Buffer& buffer, const Cell& cell, ClientCell& known, bool full) const;
+
+private:
+  static constexpr size_t MaxRecordSize {31};
+
+  [[nodiscard]] int32_t quantize(float value) const;
+
+  float   m_step;
+  int32_t m_originX {0};
+  int32_t m_originY {0};
+};
+
+#endif /* THEGAME_DELTA_ENCODER_HPP */
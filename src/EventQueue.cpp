@@ -0,0 +1,26 @@
+// file   : src/EventQueue.cpp
+// author : sba <bohdan.sadovyak@gmail.com>
+
+#include "EventQueue.hpp"
+
+void EventQueue::flush()
+{
+  // handlers may emit, so the vector can grow (and move) while an event is being delivered
+  while (m_next < m_events.size()) {
+    Event event = m_events[m_next++];
+    if (event.emitter) {
+      event.dispatch(event.emitter, event.payload);
+    }
+  }
+  m_events.clear();
+  m_next = 0;
+}
+
+void EventQueue::cancel(const void* emitter)
+{
+  for (auto i = m_next; i < m_events.size(); ++i) {
+    if (m_events[i].emitter == emitter) {
+      m_events[i].emitter = nullptr;
+    }
+  }
+}
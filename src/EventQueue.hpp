@@ -0,0 +1,198 @@
+// file   : src/EventQueue.hpp
+// author : sba <bohdan.sadovyak@gmail.com>
+
+#ifndef THEGAME_EVENT_QUEUE_HPP
+#define THEGAME_EVENT_QUEUE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+template <typename... Args>
+class DeferredEmitter;
+
+// FIFO of events waiting to be delivered to the subscribers of their DeferredEmitter. An event is a flat record: the
+// emitter, a typed dispatch function and the arguments packed by value, so queueing one allocates nothing once the
+// queue has grown. flush() delivers the events in the order they were emitted, including the ones emitted by the
+// handlers while flushing, which is the order asio::post gave for the emitters this replaces.
+class EventQueue {
+public:
+  EventQueue() = default;
+  EventQueue(const EventQueue&) = delete;
+  EventQueue& operator=(const EventQueue&) = delete;
+
+  void flush();
+
+  // Drops the pending events of an emitter that is being destroyed.
+  void cancel(const void* emitter);
+
+  [[nodiscard]] size_t size() const { return m_events.size() - m_next; }
+  [[nodiscard]] bool empty() const { return size() == 0; }
+
+private:
+  template <typename... Args>
+  friend class DeferredEmitter;
+
+  using Payload = std::byte[8];
+
+  struct Event {
+    void          (*dispatch)(void* emitter, const std::byte* payload);
+    void*         emitter;
+    alignas(8) Payload payload;
+  };
+
+  template <typename... Args>
+  void push(DeferredEmitter<Args...>& emitter, Args... args);
+
+  template <typename T>
+  static T load(const std::byte*& cursor);
+
+  std::vector<Event>  m_events;
+  size_t              m_next {0};             // the first event not delivered yet
+};
+
+// Event source whose emit() only queues the event in an EventQueue; the subscribers are called when the queue is
+// flushed. Subscribers are called in subscription order. They may subscribe and unsubscribe, on this emitter too,
+// from inside a handler: a handler unsubscribed while the event is being delivered is not called anymore, one
+// subscribed meanwhile gets the next event.
+template <typename... Args>
+class DeferredEmitter {
+public:
+  using Handler = std::function<void(Args...)>;
+
+  explicit DeferredEmitter(EventQueue& queue) : m_queue(queue) {}
+  DeferredEmitter(const DeferredEmitter&) = delete;
+  DeferredEmitter& operator=(const DeferredEmitter&) = delete;
+
+  ~DeferredEmitter()
+  {
+    if (m_pending) {
+      m_queue.cancel(this);
+    }
+  }
+
+  void subscribe(void* tag, Handler&& handler)
+  {
+    if (find(tag) != m_subscribers.end()) {
+      return;
+    }
+    if (m_dispatching) {
+      m_added.push_back({tag, std::move(handler)});
+    } else {
+      m_subscribers.push_back({tag, std::move(handler)});
+    }
+  }
+
+  void unsubscribe(void* tag)
+  {
+    std::erase_if(m_added, [tag](const auto& subscriber) { return subscriber.tag == tag; });
+    auto it = find(tag);
+    if (it == m_subscribers.end()) {
+      return;
+    }
+    if (m_dispatching) {
+      it->tag = nullptr;                      // keep the handler alive, it may be the one running
+      m_removed = true;
+    } else {
+      m_subscribers.erase(it);
+    }
+  }
+
+  void emit(Args... args)
+  {
+    if (!m_subscribers.empty()) {
+      m_queue.push(*this, args...);
+    }
+  }
+
+  void clear()
+  {
+    if (m_dispatching) {
+      for (auto& subscriber : m_subscribers) {
+        subscriber.tag = nullptr;
+      }
+      m_removed = true;
+    } else {
+      m_subscribers.clear();
+    }
+    m_added.clear();
+  }
+
+private:
+  friend class EventQueue;
+
+  struct Subscriber {
+    void*   tag;
+    Handler handler;
+  };
+
+  using Subscribers = std::vector<Subscriber>;
+
+  typename Subscribers::iterator find(void* tag)
+  {
+    return std::find_if(m_subscribers.begin(), m_subscribers.end(), [tag](const auto& s) { return s.tag == tag; });
+  }
+
+  void dispatch(Args... args)
+  {
+    --m_pending;
+    m_dispatching = true;
+    for (const auto& subscriber : m_subscribers) {
+      if (subscriber.tag) {
+        subscriber.handler(args...);
+      }
+    }
+    m_dispatching = false;
+    if (m_removed) {
+      std::erase_if(m_subscribers, [](const auto& subscriber) { return !subscriber.tag; });
+      m_removed = false;
+    }
+    if (!m_added.empty()) {
+      std::move(m_added.begin(), m_added.end(), std::back_inserter(m_subscribers));
+      m_added.clear();
+    }
+  }
+
+  EventQueue&   m_queue;
+  Subscribers   m_subscribers;
+  Subscribers   m_added;                      // subscribed while dispatching
+  uint32_t      m_pending {0};                // events in the queue
+  bool          m_dispatching {false};
+  bool          m_removed {false};
+};
+
+template <typename... Args>
+void EventQueue::push(DeferredEmitter<Args...>& emitter, Args... args)
+{
+  static_assert((std::is_trivially_copyable_v<Args> && ...) && (sizeof(Args) + ... + 0) <= sizeof(Payload));
+
+  Event& event = m_events.emplace_back();
+  event.emitter = &emitter;
+  event.dispatch = [](void* target, [[maybe_unused]] const std::byte* payload) {
+    // braced initialization reads the arguments left to right
+    std::tuple<Args...> arguments {load<Args>(payload)...};
+    std::apply([target](auto... values) { static_cast<DeferredEmitter<Args...>*>(target)->dispatch(values...); },
+      arguments
+    );
+  };
+  auto* cursor = event.payload;
+  ((std::memcpy(cursor, &args, sizeof(Args)), cursor += sizeof(Args)), ...);
+  ++emitter.m_pending;
+}
+
+template <typename T>
+T EventQueue::load(const std::byte*& cursor)
+{
+  T value;
+  std::memcpy(&value, cursor, sizeof(T));
+  cursor += sizeof(T);
+  return value;
+}
+
+#endif /* THEGAME_EVENT_QUEUE_HPP */
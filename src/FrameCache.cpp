@@ -0,0 +1,94 @@
+// file   : src/FrameCache.cpp
+// author : sba <bohdan.sadovyak@gmail.com>
+
+#include "FrameCache.hpp"
+
+#include "CellRegistry.hpp"
+
+#include "entity/Cell.hpp"
+
+void FrameCache::build(const Gridmap& gridmap, CellRegistry& modified, bool encode)
+{
+  m_gridmap = &gridmap;
+  m_modified = &modified;
+  m_data.clear();
+  m_border.clear();
+  m_owned.clear();
+
+  const auto& cells = modified.cells();
+  const auto sectors = gridmap.getSectorCount();
+  m_sectorStart.assign(sectors + 1, 0);
+  m_records.resize(cells.size());
+
+  // counting sort by home sector
+  std::vector<uint32_t> homes(cells.size());
+  for (size_t i = 0; i < cells.size(); ++i) {
+    const auto& position = cells[i]->position;
+    SectorRange range;
+    homes[i] = gridmap.getSectorRange(AABB(position, position), range)
+      ? gridmap.getSectorIndex(range.rowStart, range.colStart)
+      : 0;
+    ++m_sectorStart[homes[i] + 1];
+  }
+  for (uint32_t sector = 0; sector < sectors; ++sector) {
+    m_sectorStart[sector + 1] += m_sectorStart[sector];
+  }
+  std::vector<uint32_t> next(m_sectorStart.begin(), m_sectorStart.end() - 1);
+  for (size_t i = 0; i < cells.size(); ++i) {
+    m_records[next[homes[i]]++] = {cells[i], 0, 0};
+  }
+
+  for (auto& record : m_records) {
+    Cell& cell = *record.cell;
+    if (encode) {
+      record.offset = static_cast<uint32_t>(m_data.size());
+      cell.format(m_data);
+      record.size = static_cast<uint32_t>(m_data.size()) - record.offset;
+    }
+
+    SectorRange range;
+    if (gridmap.getSectorRange(cell.getAABB(), range)
+      && (range.rowStart != range.rowEnd || range.colStart != range.colEnd)
+    ) {
+      m_border.push_back(record);
+    }
+    if (cell.player) {
+      m_owned[cell.player].push_back(record);
+    }
+  }
+}
+
+bool FrameCache::isModified(const Cell* cell) const
+{
+  return m_modified->contains(cell);
+}
+
+FrameCache::Records FrameCache::getRow(uint32_t row, uint32_t colStart, uint32_t colEnd) const
+{
+  auto first = m_sectorStart[m_gridmap->getSectorIndex(row, colStart)];
+  auto last = m_sectorStart[m_gridmap->getSectorIndex(row, colEnd) + 1];
+  return Records(m_records).subspan(first, last - first);
+}
+
+FrameCache::Records FrameCache::getOwned(const Player* player) const
+{
+  auto it = m_owned.find(player);
+  return it != m_owned.end() ? Records(it->second) : Records();
+}
+
+bool FrameCache::isInside(const Record& record, const SectorRange& range) const
+{
+  SectorRange home;
+  const auto& position = record.cell->position;
+  return m_gridmap->getSectorRange(AABB(position, position), home) && range.contains(home.rowStart, home.colStart);
+}
+
+void FrameCache::append(Buffer& buffer, Records records) const
+{
+  if (records.empty()) {
+    return;
+  }
+  auto first = m_data.begin() + records.front().offset;
+  auto last = m_data.begin() + records.back().offset + records.back().size;
+  buffer.insert(buffer.end(), first, last);
+}
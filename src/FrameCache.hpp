@@ -0,0 +1,64 @@
+// file   : src/FrameCache.hpp
+// author : sba <bohdan.sadovyak@gmail.com>
+
+#ifndef THEGAME_FRAME_CACHE_HPP
+#define THEGAME_FRAME_CACHE_HPP
+
+#include "Gridmap.hpp"
+#include "types.hpp"
+
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+class Cell;
+class CellRegistry;
+class Player;
+
+// Cells modified since the previous sync, each serialized once with Cell::format for all players of the room. The
+// records are grouped by the sector holding the cell's center (its home sector) in row-major order, so the records of
+// a run of sectors in one row are contiguous both in records() and in data(): a player copies the part of its
+// viewport that lies in one row with a single append. Rebuilt by the room at every sync.
+class FrameCache {
+public:
+  struct Record {
+    Cell*     cell;
+    uint32_t  offset;                   // encoded record in data()
+    uint32_t  size;
+  };
+
+  using Records = std::span<const Record>;
+
+  // Without `encode` the records only group the cells, data() stays empty and append() must not be used.
+  void build(const Gridmap& gridmap, CellRegistry& modified, bool encode = true);
+
+  [[nodiscard]] bool isModified(const Cell* cell) const;
+
+  // Records homed in sectors [colStart, colEnd] of the row.
+  [[nodiscard]] Records getRow(uint32_t row, uint32_t colStart, uint32_t colEnd) const;
+  // Records whose cell reaches outside its home sector, and so may be visible from a viewport not containing it.
+  [[nodiscard]] Records getBorder() const { return m_border; }
+  // Records of the player's avatars.
+  [[nodiscard]] Records getOwned(const Player* player) const;
+
+  // True if the record's home sector lies in the range.
+  [[nodiscard]] bool isInside(const Record& record, const SectorRange& range) const;
+
+  // Appends the encoded records, which must be contiguous (a span returned by getRow or a single record).
+  void append(Buffer& buffer, Records records) const;
+
+  [[nodiscard]] const Buffer& data() const { return m_data; }
+  [[nodiscard]] Records records() const { return m_records; }
+
+private:
+  const Gridmap*                                        m_gridmap {nullptr};
+  const CellRegistry*                                   m_modified {nullptr};
+  Buffer                                                m_data;
+  std::vector<Record>                                   m_records;
+  std::vector<uint32_t>                                 m_sectorStart;  // first record of each sector, plus the end
+  std::vector<Record>                                   m_border;
+  std::unordered_map<const Player*, std::vector<Record>> m_owned;
+};
+
+#endif /* THEGAME_FRAME_CACHE_HPP */
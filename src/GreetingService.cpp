@@ -0,0 +1,47 @@
+// file   : src/GreetingService.cpp
+// author : sba <bohdan.sadovyak@gmail.com>
+
+#include "GreetingService.hpp"
+
+#include "UsersCache.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <boost/asio/post.hpp>
+
+GreetingService::GreetingService(const asio::any_io_executor& executor, UsersCache& users)
+  : m_executor(executor)
+  , m_users(users)
+{
+}
+
+void GreetingService::greet(
+  std::string token,
+  uint32_t ip,
+  const asio::any_io_executor& handlerExecutor,
+  Handler&& handler
+)
+{
+  asio::post(m_executor,
+    [this, token = std::move(token), ip, handlerExecutor, handler = std::move(handler)]() mutable
+    {
+      Result result;
+      try {
+        result.user = m_users.getUserByToken(token);
+        if (!result.user) {
+          result.user = m_users.create(ip);
+          result.created = true;
+        }
+      } catch (const std::exception& e) {
+        spdlog::error("An exception occurred while looking up the user: {}", e.what());
+        result = {};
+      }
+      asio::post(handlerExecutor,
+        [handler = std::move(handler), result = std::move(result)]
+        {
+          handler(result);
+        }
+      );
+    }
+  );
+}
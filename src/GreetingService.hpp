@@ -0,0 +1,39 @@
+// file   : src/GreetingService.hpp
+// author : sba <bohdan.sadovyak@gmail.com>
+
+#ifndef THEGAME_GREETING_SERVICE_HPP
+#define THEGAME_GREETING_SERVICE_HPP
+
+#include "UserFwd.hpp"
+
+#include <boost/asio/any_io_executor.hpp>
+
+#include <functional>
+#include <string>
+
+namespace asio = boost::asio;
+
+class UsersCache;
+
+// Finds the user of a greeting, or registers a new one, on the DB workers, so that the IO threads never wait for the
+// storage. Greetings with different tokens are looked up in parallel.
+class GreetingService {
+public:
+  struct Result {
+    UserPtr user;                       // null if the storage failed
+    bool    created {false};
+  };
+
+  using Handler = std::function<void(const Result& result)>;
+
+  GreetingService(const asio::any_io_executor& executor, UsersCache& users);
+
+  // The handler is called on handlerExecutor, usually the session's.
+  void greet(std::string token, uint32_t ip, const asio::any_io_executor& handlerExecutor, Handler&& handler);
+
+private:
+  asio::any_io_executor m_executor;
+  UsersCache&           m_users;
+};
+
+#endif /* THEGAME_GREETING_SERVICE_HPP */
@@ -9,8 +9,14 @@
 
 #include <spdlog/spdlog.h>
 
-void Gridmap::resize(uint32_t width, uint32_t height, uint8_t power)
+#include <bit>
+
+void Gridmap::resize(uint32_t width, uint32_t height, uint8_t power, Index index)
 {
+  m_index = index;
+  if (m_index == Index::Quadtree) {
+    m_quadtree.resize(width, height, power);
+  }
   m_box.b.x = static_cast<float>(width - 1);
   m_box.b.y = static_cast<float>(height - 1);
   m_width = width;
@@ -19,7 +25,10 @@ void Gridmap::resize(uint32_t width, uint32_t height, uint8_t power)
   uint32_t sectorSize = 1 << power;
   m_rowCount = (height + sectorSize - 1) >> power;
   m_colCount = (width + sectorSize - 1) >> power;
+  m_sectors.clear();
   m_sectors.resize(m_rowCount * m_colCount);
+  ++m_generation;
+  m_size = 0;
   int id = 0, x = 0, y = 0;
   for (Sector& sector : m_sectors) {
     sector.box = AABB(x, y, x + sectorSize - 1, y + sectorSize - 1);
@@ -71,152 +80,327 @@ std::set<Sector*> Gridmap::getSectors(const AABB& box) const
 
 void Gridmap::insert(Cell* cell)
 {
-  if (cell->materialPoint) {
-    Sector* sector = getSector(cell->position);
-    assert(sector);
-    if (sector) {
-      sector->cells.insert(cell);
-      cell->sectors.insert(sector);
-    }
+  if (m_index == Index::Quadtree) {
+    m_quadtree.insert(cell, makeBounds(*cell));
     return;
   }
-  Vec2D delta(cell->radius, cell->radius);
-  AABB aabb(cell->position - delta, cell->position + delta);
-  aabb = clip(aabb);
-  if (aabb.a.x > aabb.b.x || aabb.a.y > aabb.b.y) {
+  auto& span = cell->sectors;
+  span.slots.clear();
+  if (!getSpan(*cell, span)) {
     return;
   }
-  cell->leftTopSector = getSector(aabb.a);
-  cell->rightBottomSector = getSector(aabb.b);
-  assert(cell->leftTopSector);
-  assert(cell->rightBottomSector);
-  uint32_t rowStart = static_cast<uint32_t>(aabb.a.y) >> m_power;
-  uint32_t rowEnd = static_cast<uint32_t>(aabb.b.y) >> m_power;
-  uint32_t colStart = static_cast<uint32_t>(aabb.a.x) >> m_power;
-  uint32_t colEnd = static_cast<uint32_t>(aabb.b.x) >> m_power;
-  uint32_t sectorSize = 1 << m_power;
-  int32_t y = rowStart * sectorSize;
-  for (auto row = rowStart; row <= rowEnd; ++row) {
-    int32_t x = colStart * sectorSize;
-    for (auto col = colStart; col <= colEnd; ++col) {
-      AABB box(x, y, x + sectorSize, y + sectorSize);
-      x += sectorSize;
-      if (geometry::intersects(box, *cell)) {
-        Sector* sector = &m_sectors.at(row * m_colCount + col);
-        sector->cells.insert(cell);
-        cell->sectors.insert(sector);
-      }
+  for (auto row = span.rowStart; row <= span.rowEnd; ++row) {
+    for (auto col = span.colStart; col <= span.colEnd; ++col) {
+      span.slots.push_back(attach(row, col, cell));
     }
-    y += sectorSize;
   }
+  ++m_size;
 }
 
 void Gridmap::erase(Cell* cell)
 {
-  for (Sector* sector : cell->sectors) {
-    sector->cells.erase(cell);
+  if (m_index == Index::Quadtree) {
+    m_quadtree.erase(cell);
+    return;
+  }
+  auto& span = cell->sectors;
+  if (span.empty()) {
+    return;
   }
-  cell->sectors.clear();
+  auto it = span.slots.begin();
+  for (auto row = span.rowStart; row <= span.rowEnd; ++row) {
+    for (auto col = span.colStart; col <= span.colEnd; ++col) {
+      detach(row, col, *it++, cell->materialPoint);
+    }
+  }
+  span.slots.clear();
+  --m_size;
 }
 
 void Gridmap::update(Cell* cell)
 {
-  if (cell->materialPoint) {
-    Sector* current = *cell->sectors.begin();
-    Sector* sector = getSector(cell->position);
-    assert(sector);
-    if (current != sector) {
-      current->cells.erase(cell);
-      cell->sectors.clear();
-      sector->cells.insert(cell);
-      cell->sectors.insert(sector);
-    }
+  if (m_index == Index::Quadtree) {
+    m_quadtree.update(cell, makeBounds(*cell));
     return;
   }
-  Vec2D delta(cell->radius, cell->radius);
-  AABB aabb(cell->position - delta, cell->position + delta);
-  aabb = clip(aabb);
-  if (aabb.a.x > aabb.b.x || aabb.a.y > aabb.b.y) {
+  auto& current = cell->sectors;
+  if (current.empty()) {
+    insert(cell);
     return;
   }
-  Sector* leftTopSector = getSector(aabb.a);
-  Sector* rightBottomSector = getSector(aabb.b);
-  assert(leftTopSector);
-  assert(rightBottomSector);
-  if (cell->leftTopSector == leftTopSector && cell->rightBottomSector == rightBottomSector) {
+  SectorSpan next;
+  if (!getSpan(*cell, next)) {
     return;
   }
-  cell->leftTopSector = leftTopSector;
-  cell->rightBottomSector = rightBottomSector;
-  uint32_t rowStart = static_cast<uint32_t>(aabb.a.y) >> m_power;
-  uint32_t rowEnd = static_cast<uint32_t>(aabb.b.y) >> m_power;
-  uint32_t colStart = static_cast<uint32_t>(aabb.a.x) >> m_power;
-  uint32_t colEnd = static_cast<uint32_t>(aabb.b.x) >> m_power;
-  uint32_t sectorSize = 1 << m_power;
-  int32_t y = rowStart * sectorSize;
-  for (Sector* sector : cell->sectors) {
-    sector->cells.erase(cell);
+  if (static_cast<const SectorRange&>(next) == current) {
+    auto it = current.slots.begin();
+    for (auto row = current.rowStart; row <= current.rowEnd; ++row) {
+      for (auto col = current.colStart; col <= current.colEnd; ++col) {
+        refresh(row, col, *it++, *cell);
+      }
+    }
+    return;
   }
-  cell->sectors.clear();
-  for (auto row = rowStart; row <= rowEnd; ++row) {
-    int32_t x = colStart * sectorSize;
-    for (auto col = colStart; col <= colEnd; ++col) {
-      AABB box(x, y, x + sectorSize, y + sectorSize);
-      x += sectorSize;
-      if (geometry::intersects(box, *cell)) {
-        Sector* sector = &m_sectors.at(row * m_colCount + col);
-        sector->cells.insert(cell);
-        cell->sectors.insert(sector);
+  auto it = current.slots.begin();
+  for (auto row = current.rowStart; row <= current.rowEnd; ++row) {
+    for (auto col = current.colStart; col <= current.colEnd; ++col) {
+      auto index = *it++;
+      if (!next.contains(row, col)) {
+        detach(row, col, index, cell->materialPoint);
       }
     }
-    y += sectorSize;
   }
+  for (auto row = next.rowStart; row <= next.rowEnd; ++row) {
+    for (auto col = next.colStart; col <= next.colEnd; ++col) {
+      if (current.contains(row, col)) {
+        auto index = current.slot(row, col);
+        refresh(row, col, index, *cell);
+        next.slots.push_back(index);
+      } else {
+        next.slots.push_back(attach(row, col, cell));
+      }
+    }
+  }
+  current = std::move(next);
 }
 
-void Gridmap::query(const AABB& box, const Handler& handler) const
+size_t Gridmap::count(const AABB& box) const
 {
   AABB aabb(clip(box));
-  if (aabb.a.x > aabb.b.x || aabb.a.y > aabb.b.y) {
-    return;
+  SectorRange range;
+  if (!getRange(aabb, range)) {
+    return 0;
   }
-  uint32_t rowStart = static_cast<uint32_t>(aabb.a.y) >> m_power;
-  uint32_t rowEnd = static_cast<uint32_t>(aabb.b.y) >> m_power;
-  uint32_t colStart = static_cast<uint32_t>(aabb.a.x) >> m_power;
-  uint32_t colEnd = static_cast<uint32_t>(aabb.b.x) >> m_power;
-  for (auto row = rowStart; row <= rowEnd; ++row) {
-    for (auto col = colStart; col <= colEnd; ++col) {
-      const Sector& sector = m_sectors.at(row * m_colCount + col);
-      for (Cell* obj : sector.cells) {
-        if (obj->intersects(aabb)) {
-          if (!handler(*obj)) {
-            return;
+  if (m_index == Index::Quadtree) {
+    return m_quadtree.count(aabb);
+  }
+  size_t cnt = 0;
+  for (auto row = range.rowStart; row <= range.rowEnd; ++row) {
+    for (auto col = range.colStart; col <= range.colEnd; ++col) {
+      const Sector& sector = m_sectors[row * m_colCount + col];
+      const auto size = sector.bounds.size();
+      for (size_t i = 0; i < size; ++i) {
+        if (geometry::intersects(aabb, sector.bounds[i].position) && !sector.cells[i]->zombie) {
+          ++cnt;
+        }
+      }
+      const auto points = sector.points.size();
+      for (size_t first = 0; first < points; first += geometry::KernelBatchSize) {
+        auto count = std::min(points - first, geometry::KernelBatchSize);
+        auto mask = geometry::pointsInBox(aabb, &sector.xs[first], &sector.ys[first], count);
+        for (; mask; mask &= mask - 1) {
+          cnt += !sector.points[first + std::countr_zero(mask)]->zombie;
+        }
+      }
+    }
+  }
+  return cnt;
+}
+
+bool Gridmap::getSectorRange(const AABB& box, SectorRange& range) const
+{
+  return getRange(clip(box), range);
+}
+
+bool Gridmap::contains(const Cell* cell) const
+{
+  return m_index == Index::Quadtree ? !cell->quadtreeSlot.empty() : !cell->sectors.empty();
+}
+
+uint8_t Gridmap::getPower() const
+{
+  return m_power;
+}
+
+Gridmap::Index Gridmap::getIndex() const
+{
+  return m_index;
+}
+
+Gridmap::Stats Gridmap::getStats() const
+{
+  Stats stats;
+  stats.power = m_power;
+  auto account = [&stats](size_t members) {
+    auto size = static_cast<uint32_t>(members);
+    auto bucket = std::min<size_t>(std::bit_width(size), stats.histogram.size() - 1);
+    ++stats.histogram[bucket];
+    stats.entries += size;
+    stats.maxSectorCells = std::max(stats.maxSectorCells, size);
+  };
+  if (m_index == Index::Quadtree) {
+    stats.cells = m_quadtree.size();
+    stats.sectors = static_cast<uint32_t>(m_quadtree.nodes().size());
+    for (const auto& node : m_quadtree.nodes()) {
+      account(node.cells.size());
+    }
+  } else {
+    stats.cells = m_size;
+    stats.sectors = static_cast<uint32_t>(m_sectors.size());
+    for (const Sector& sector : m_sectors) {
+      account(sector.cells.size() + sector.points.size());
+    }
+  }
+  if (stats.sectors) {
+    stats.meanSectorCells = static_cast<double>(stats.entries) / stats.sectors;
+  }
+  if (stats.cells) {
+    stats.meanSectorsPerCell = static_cast<double>(stats.entries) / stats.cells;
+  }
+  return stats;
+}
+
+void Gridmap::rebuild(uint8_t power)
+{
+  std::vector<Cell*> cells;
+  if (m_index == Index::Quadtree) {
+    cells.reserve(m_quadtree.size());
+    for (const auto& node : m_quadtree.nodes()) {
+      cells.insert(cells.end(), node.cells.begin(), node.cells.end());
+    }
+    for (auto* cell : cells) {
+      cell->quadtreeSlot = {};
+    }
+  } else {
+    cells.reserve(m_size);
+    for (uint32_t row = 0; row < m_rowCount; ++row) {
+      for (uint32_t col = 0; col < m_colCount; ++col) {
+        const Sector& sector = m_sectors[row * m_colCount + col];
+        for (auto* cell : sector.cells) {
+          const auto& span = cell->sectors;
+          if (span.rowStart == row && span.colStart == col) {
+            cells.push_back(cell);
           }
         }
+        cells.insert(cells.end(), sector.points.begin(), sector.points.end());
       }
     }
   }
+  resize(m_width, m_height, power, m_index);
+  for (auto* cell : cells) {
+    insert(cell);
+  }
 }
 
-size_t Gridmap::count(const AABB& box) const
+void Gridmap::collect(const AABB& box, std::vector<Cell*>& result) const
+{
+  result.clear();
+  query(box, [&](Cell& cell) {
+    result.push_back(&cell);
+    return true;
+  });
+}
+
+bool Gridmap::getRange(const AABB& aabb, SectorRange& range) const
+{
+  if (aabb.a.x > aabb.b.x || aabb.a.y > aabb.b.y) {
+    return false;
+  }
+  range.rowStart = static_cast<uint32_t>(aabb.a.y) >> m_power;
+  range.rowEnd = static_cast<uint32_t>(aabb.b.y) >> m_power;
+  range.colStart = static_cast<uint32_t>(aabb.a.x) >> m_power;
+  range.colEnd = static_cast<uint32_t>(aabb.b.x) >> m_power;
+  return true;
+}
+
+bool Gridmap::getSpan(const Cell& cell, SectorSpan& span) const
+{
+  auto radius = cell.materialPoint ? 0 : cell.radius;
+  Vec2D delta(radius, radius);
+  return getRange(clip(AABB(cell.position - delta, cell.position + delta)), span);
+}
+
+uint32_t Gridmap::getSpanSize(const AABB& box, uint8_t power) const
 {
   const AABB& aabb(clip(box));
   if (aabb.a.x > aabb.b.x || aabb.a.y > aabb.b.y) {
     return 0;
   }
-  uint32_t rowStart = static_cast<uint32_t>(aabb.a.y) >> m_power;
-  uint32_t rowEnd = static_cast<uint32_t>(aabb.b.y) >> m_power;
-  uint32_t colStart = static_cast<uint32_t>(aabb.a.x) >> m_power;
-  uint32_t colEnd = static_cast<uint32_t>(aabb.b.x) >> m_power;
-  size_t cnt = 0;
-  for (auto row = rowStart; row <= rowEnd; ++row) {
-    for (auto col = colStart; col <= colEnd; ++col) {
-      const Sector& sector = m_sectors.at(row * m_colCount + col);
-      for (Cell* obj : sector.cells) {
-        if (!obj->zombie && geometry::intersects(aabb, obj->position)) {
-          ++cnt;
+  auto rows = (static_cast<uint32_t>(aabb.b.y) >> power) - (static_cast<uint32_t>(aabb.a.y) >> power) + 1;
+  auto cols = (static_cast<uint32_t>(aabb.b.x) >> power) - (static_cast<uint32_t>(aabb.a.x) >> power) + 1;
+  return rows * cols;
+}
+
+size_t Gridmap::countEntries(uint8_t power) const
+{
+  if (power == m_power) {
+    return getStats().entries;
+  }
+  size_t entries = 0;
+  for (uint32_t row = 0; row < m_rowCount; ++row) {
+    for (uint32_t col = 0; col < m_colCount; ++col) {
+      const Sector& sector = m_sectors[row * m_colCount + col];
+      entries += sector.points.size(); // a point takes one sector at any power
+      const auto size = sector.cells.size();
+      for (size_t i = 0; i < size; ++i) {
+        const auto& span = sector.cells[i]->sectors;
+        if (span.rowStart == row && span.colStart == col) {
+          const auto& bounds = sector.bounds[i];
+          Vec2D delta(bounds.radius, bounds.radius);
+          entries += getSpanSize(AABB(bounds.position - delta, bounds.position + delta), power);
         }
       }
     }
   }
-  return cnt;
+  return entries;
+}
+
+uint32_t Gridmap::attach(uint32_t row, uint32_t col, Cell* cell)
+{
+  Sector& sector = m_sectors[row * m_colCount + col];
+  if (cell->materialPoint) {
+    auto index = static_cast<uint32_t>(sector.points.size());
+    sector.points.push_back(cell);
+    sector.xs.push_back(cell->position.x);
+    sector.ys.push_back(cell->position.y);
+    return index;
+  }
+  auto index = static_cast<uint32_t>(sector.cells.size());
+  sector.cells.push_back(cell);
+  sector.bounds.push_back(makeBounds(*cell));
+  return index;
+}
+
+void Gridmap::detach(uint32_t row, uint32_t col, uint32_t index, bool point)
+{
+  Sector& sector = m_sectors[row * m_colCount + col];
+  if (point) {
+    auto last = static_cast<uint32_t>(sector.points.size() - 1);
+    if (index != last) {
+      Cell* moved = sector.points[last];
+      sector.points[index] = moved;
+      sector.xs[index] = sector.xs[last];
+      sector.ys[index] = sector.ys[last];
+      moved->sectors.slot(row, col) = index;
+    }
+    sector.points.pop_back();
+    sector.xs.pop_back();
+    sector.ys.pop_back();
+    return;
+  }
+  auto last = static_cast<uint32_t>(sector.cells.size() - 1);
+  if (index != last) {
+    Cell* moved = sector.cells[last];
+    sector.cells[index] = moved;
+    sector.bounds[index] = sector.bounds[last];
+    moved->sectors.slot(row, col) = index;
+  }
+  sector.cells.pop_back();
+  sector.bounds.pop_back();
+}
+
+void Gridmap::refresh(uint32_t row, uint32_t col, uint32_t index, const Cell& cell)
+{
+  Sector& sector = m_sectors[row * m_colCount + col];
+  if (cell.materialPoint) {
+    sector.xs[index] = cell.position.x;
+    sector.ys[index] = cell.position.y;
+  } else {
+    sector.bounds[index] = makeBounds(cell);
+  }
+}
+
+Circle Gridmap::makeBounds(const Cell& cell)
+{
+  return {cell.position, cell.materialPoint ? 0 : cell.radius};
 }
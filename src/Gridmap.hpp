@@ -4,44 +4,327 @@
 #ifndef THEGAME_GRIDMAP_HPP
 #define THEGAME_GRIDMAP_HPP
 
+#include "LooseQuadtree.hpp"
+
 #include "geometry/AABB.hpp"
+#include "geometry/Circle.hpp"
+#include "geometry/geometry.hpp"
+#include "geometry/kernels.hpp"
+
+#include <boost/container/small_vector.hpp>
 
+#include <algorithm>
+#include <array>
+#include <bit>
 #include <cstdint>
 #include <functional>
 #include <set>
-#include <unordered_set>
 #include <vector>
 
 class Cell;
 
+// Members of a sector are kept in two parallel arrays: `cells` and `bounds` share the same index. A cell is removed
+// by moving the last member into its slot, so both arrays stay dense and queries stream through them linearly.
+// `bounds` holds a copy of the position and radius of every member.
+// Material points (food) dominate the population and always fit in one sector, so they are kept apart in a point
+// layer: `points` with the coordinates packed into `xs` and `ys`, tested in batches by geometry::pointsInBox.
 struct Sector {
-  std::unordered_set<Cell*> cells;
-  AABB box;
+  std::vector<Cell*>  cells;
+  std::vector<Circle> bounds;
+  std::vector<Cell*>  points;
+  std::vector<float>  xs;
+  std::vector<float>  ys;
+  AABB                box;
+};
+
+// Inclusive rectangle of sectors in row/column coordinates.
+struct SectorRange {
+  [[nodiscard]] bool contains(uint32_t row, uint32_t col) const
+  {
+    return row >= rowStart && row <= rowEnd && col >= colStart && col <= colEnd;
+  }
+
+  bool operator==(const SectorRange& other) const = default;
+
+  uint32_t  rowStart {0};
+  uint32_t  rowEnd {0};
+  uint32_t  colStart {0};
+  uint32_t  colEnd {0};
+};
+
+// Rectangle of sectors occupied by a cell together with the cell's index inside each of them (row-major). Cells
+// covering up to four sectors keep their slots inline, so moving across sector borders does not allocate.
+struct SectorSpan : SectorRange {
+  using Slots = boost::container::small_vector<uint32_t, 4>;
+
+  [[nodiscard]] bool empty() const { return slots.empty(); }
+  [[nodiscard]] uint32_t& slot(uint32_t row, uint32_t col)
+  {
+    return slots[(row - rowStart) * (colEnd - colStart + 1) + col - colStart];
+  }
+
+  Slots slots;
 };
 
+// Spatial index of the room. Cells are bucketed either into the uniform grid of sectors or into a loose quadtree; the
+// sectors are always kept as the tiling used for player viewports, but hold members only in the Grid mode.
 class Gridmap {
 public:
+  enum class Index { Grid, Quadtree };
+
   using Handler = std::function<bool(Cell&)>;
+  using CellPairs = std::vector<std::pair<Cell*, Cell*>>;
+
+  enum Layers : uint8_t {
+    Extents = 1,                        // cells with a radius
+    Points = 2,                         // material points (food)
+    AllLayers = Extents | Points
+  };
 
-  void resize(uint32_t width, uint32_t height, uint8_t power);
+  // Occupancy snapshot. histogram[0] counts empty sectors, histogram[i] counts sectors holding [2^(i-1), 2^i) cells,
+  // the last bucket is open-ended.
+  struct Stats {
+    std::array<uint32_t, 12> histogram {};
+    size_t    cells {0};
+    size_t    entries {0};                // sum of sectors over cells
+    uint32_t  sectors {0};
+    uint32_t  maxSectorCells {0};
+    double    meanSectorCells {0};
+    double    meanSectorsPerCell {0};
+    uint8_t   power {0};
+  };
+
+  void resize(uint32_t width, uint32_t height, uint8_t power, Index index = Index::Grid);
   AABB clip(const AABB& box) const;
   Sector* getSector(const Vec2D& point) const;
   std::set<Sector*> getSectors(const AABB& box) const;
 
+  // Sectors covered by the box after clipping; false if nothing of the box is left.
+  bool getSectorRange(const AABB& box, SectorRange& range) const;
+  // Row-major index of a sector, in [0, getSectorCount()).
+  uint32_t getSectorIndex(uint32_t row, uint32_t col) const { return row * m_colCount + col; }
+  uint32_t getSectorCount() const { return m_rowCount * m_colCount; }
+
   void insert(Cell* cell);
   void erase(Cell* cell);
   void update(Cell* cell);
-  void query(const AABB& box, const Handler& handler) const;
+  // Whether the cell is indexed, whichever index holds it.
+  bool contains(const Cell* cell) const;
   size_t count(const AABB& box) const;
 
+  uint8_t getPower() const;
+  Index getIndex() const;
+  // Changes whenever the sectors are reallocated (resize, rebuild): Sector pointers taken before are dangling.
+  uint32_t getGeneration() const { return m_generation; }
+  Stats getStats() const;
+
+  // Re-buckets every cell into sectors (or the finest quadtree nodes) of size 2^power.
+  void rebuild(uint8_t power);
+
+  // Picks the power in [minPower, maxPower] with the lowest estimated cost of querying and updating the `queries`
+  // cells once. Keeps the current power unless another one is at least 10% cheaper. Always keeps the current power
+  // in the Quadtree mode, whose levels already adapt to cell sizes.
+  template <typename Cells>
+  uint8_t suggestPower(const Cells& queries, uint8_t minPower, uint8_t maxPower) const;
+
+  // Calls handler(Cell&) for every cell of the given layers whose bounds intersect the box until it returns false. A
+  // cell covering several sectors is reported once per sector. The handler must not insert, erase or update cells.
+  template <typename F>
+  void query(const AABB& box, F&& handler, uint8_t layers = AllLayers) const;
+
+  // Calls handler(Cell&) for every material point strictly inside the circle and inside the box, bounds included,
+  // until it returns false. Same rules as query().
+  template <typename F>
+  void queryPoints(const Circle& circle, const AABB& box, F&& handler) const;
+
+  // Replaces the contents of `result` with the cells query() would report. Lets callers reuse one buffer across calls
+  // and modify the gridmap while handling the result.
+  void collect(const AABB& box, std::vector<Cell*>& result) const;
+
+  // Broad phase for a set of moving cells: fills `pairs` with every (cell, target) whose bounds overlap the cell's AABB.
+  // Each unordered pair is reported once even if the target covers several sectors or both cells are in `cells`.
+  // Material points are paired only through the queries of moving material points: cells with an extent pick food up
+  // with queryPoints(), which tests it in batches.
+  template <typename Cells>
+  void collectPairs(const Cells& cells, CellPairs& pairs) const;
+
 private:
+  bool getRange(const AABB& aabb, SectorRange& range) const;
+  bool getSpan(const Cell& cell, SectorSpan& span) const;
+  uint32_t attach(uint32_t row, uint32_t col, Cell* cell);
+  void detach(uint32_t row, uint32_t col, uint32_t index, bool point);
+  void refresh(uint32_t row, uint32_t col, uint32_t index, const Cell& cell);
+
+  uint32_t getSpanSize(const AABB& box, uint8_t power) const;
+  size_t countEntries(uint8_t power) const;
+
+  template <typename Cells>
+  double estimateCost(const Cells& queries, uint8_t power) const;
+
+  static Circle makeBounds(const Cell& cell);
+
+  static constexpr double SectorVisitCost {4}; // visiting a sector relative to testing one of its members
+
   mutable std::vector<Sector> m_sectors;
+  mutable uint64_t m_stamp {0};
+  LooseQuadtree m_quadtree;
+  size_t    m_size {0};
+  Index     m_index {Index::Grid};
   AABB      m_box;
   uint32_t  m_width {0};
   uint32_t  m_height {0};
   uint32_t  m_rowCount {0};
   uint32_t  m_colCount {0};
+  uint32_t  m_generation {0};
   uint8_t   m_power {0};
 };
 
+template <typename F>
+void Gridmap::query(const AABB& box, F&& handler, uint8_t layers) const
+{
+  AABB aabb(clip(box));
+  SectorRange range;
+  if (!getRange(aabb, range)) {
+    return;
+  }
+  if (m_index == Index::Quadtree) {
+    if (layers == AllLayers) {
+      m_quadtree.query(aabb, handler);
+    } else {
+      m_quadtree.query(aabb, [&](auto& cell) {
+        return (layers & (cell.materialPoint ? Points : Extents)) ? handler(cell) : true;
+      });
+    }
+    return;
+  }
+  for (auto row = range.rowStart; row <= range.rowEnd; ++row) {
+    for (auto col = range.colStart; col <= range.colEnd; ++col) {
+      const Sector& sector = m_sectors[row * m_colCount + col];
+      const auto size = layers & Extents ? sector.bounds.size() : 0;
+      for (size_t i = 0; i < size; ++i) {
+        if (geometry::intersects(aabb, sector.bounds[i])) {
+          if (!handler(*sector.cells[i])) {
+            return;
+          }
+        }
+      }
+      const auto points = layers & Points ? sector.points.size() : 0;
+      for (size_t first = 0; first < points; first += geometry::KernelBatchSize) {
+        auto count = std::min(points - first, geometry::KernelBatchSize);
+        auto mask = geometry::pointsInBox(aabb, &sector.xs[first], &sector.ys[first], count);
+        for (; mask; mask &= mask - 1) {
+          if (!handler(*sector.points[first + std::countr_zero(mask)])) {
+            return;
+          }
+        }
+      }
+    }
+  }
+}
+
+template <typename F>
+void Gridmap::queryPoints(const Circle& circle, const AABB& box, F&& handler) const
+{
+  // no point outside the circle's AABB is inside the circle
+  AABB aabb(clip(box));
+  aabb.a.x = std::max(aabb.a.x, circle.position.x - circle.radius);
+  aabb.a.y = std::max(aabb.a.y, circle.position.y - circle.radius);
+  aabb.b.x = std::min(aabb.b.x, circle.position.x + circle.radius);
+  aabb.b.y = std::min(aabb.b.y, circle.position.y + circle.radius);
+  if (m_index == Index::Quadtree) {
+    query(aabb, [&](auto& cell) {
+      bool inside = geometry::squareDistance(circle.position, cell.position) < circle.radius * circle.radius;
+      return inside ? handler(cell) : true;
+    }, Points);
+    return;
+  }
+  SectorRange range;
+  if (!getRange(aabb, range)) {
+    return;
+  }
+  for (auto row = range.rowStart; row <= range.rowEnd; ++row) {
+    for (auto col = range.colStart; col <= range.colEnd; ++col) {
+      const Sector& sector = m_sectors[row * m_colCount + col];
+      const auto points = sector.points.size();
+      for (size_t first = 0; first < points; first += geometry::KernelBatchSize) {
+        auto count = std::min(points - first, geometry::KernelBatchSize);
+        auto mask = geometry::pointsInCircle(circle, &sector.xs[first], &sector.ys[first], count)
+          & geometry::pointsInBox(aabb, &sector.xs[first], &sector.ys[first], count);
+        for (; mask; mask &= mask - 1) {
+          if (!handler(*sector.points[first + std::countr_zero(mask)])) {
+            return;
+          }
+        }
+      }
+    }
+  }
+}
+
+template <typename Cells>
+void Gridmap::collectPairs(const Cells& cells, CellPairs& pairs) const
+{
+  pairs.clear();
+  const auto firstStamp = m_stamp + 1;
+  for (auto* cell : cells) {
+    if (cell->zombie) {
+      continue;
+    }
+    const auto stamp = ++m_stamp;
+    cell->seenStamp = stamp;
+    const auto& bounds = makeBounds(*cell);
+    query(cell->getAABB(), [&](auto& target) {
+      if (target.seenStamp == stamp) {
+        return true; // already reported through another sector
+      }
+      target.seenStamp = stamp;
+      // a target that already ran its own query in this pass has reported the pair if that query covered this cell's
+      // layer and could reach it (material points have zero-sized bounds, so the two queries are not symmetric)
+      bool covered = target.materialPoint || !cell->materialPoint;
+      if (target.queryStamp >= firstStamp && covered && geometry::intersects(clip(target.getAABB()), bounds)) {
+        return true;
+      }
+      if (!target.zombie) {
+        pairs.emplace_back(cell, &target);
+      }
+      return true;
+    }, cell->materialPoint ? AllLayers : Extents);
+    cell->queryStamp = stamp;
+  }
+}
+
+template <typename Cells>
+uint8_t Gridmap::suggestPower(const Cells& queries, uint8_t minPower, uint8_t maxPower) const
+{
+  auto bestPower = m_power;
+  if (m_index == Index::Quadtree) {
+    return bestPower;
+  }
+  auto bestCost = estimateCost(queries, m_power) * 0.9;
+  for (auto power = minPower; power <= maxPower; ++power) {
+    if (power == m_power) {
+      continue;
+    }
+    auto cost = estimateCost(queries, power);
+    if (cost < bestCost) {
+      bestCost = cost;
+      bestPower = power;
+    }
+  }
+  return bestPower;
+}
+
+template <typename Cells>
+double Gridmap::estimateCost(const Cells& queries, uint8_t power) const
+{
+  // a query visits the sectors under the AABB and tests their members, assuming members are spread evenly
+  uint32_t sectorSize = 1 << power;
+  uint64_t sectors = static_cast<uint64_t>((m_height + sectorSize - 1) >> power) * ((m_width + sectorSize - 1) >> power);
+  double density = static_cast<double>(countEntries(power)) / sectors;
+  double cost = 0;
+  for (const auto* cell : queries) {
+    cost += getSpanSize(cell->getAABB(), power) * (SectorVisitCost + density);
+  }
+  return cost;
+}
+
 #endif /* THEGAME_GRIDMAP_HPP */
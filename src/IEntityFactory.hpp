@@ -16,12 +16,7 @@ class Phage;
 class Mother;
 class Vec2D;
 class Gridmap;
-
-namespace boost::asio {
-  class any_io_executor;
-}
-
-namespace asio = boost::asio;
+class EventQueue;
 
 class IEntityFactory {
 public:
@@ -43,8 +38,10 @@ public:
 
   [[nodiscard]] virtual PlayerPtr getTopPlayer() const = 0;
 
-  virtual asio::any_io_executor& getGameExecutor() = 0;
-  virtual asio::any_io_executor& getDeathExecutor() = 0;
+  // Queues of the cells' deferred events, flushed by the owner of the cells: game events (mass change, motion start
+  // and stop) first, then deaths.
+  virtual EventQueue& getGameEvents() = 0;
+  virtual EventQueue& getDeathEvents() = 0;
 };
 
 #endif /* THEGAME_I_ENTITY_FACTORY_HPP */
@@ -0,0 +1,148 @@
+// file   : src/LooseQuadtree.cpp
+// author : sba <bohdan.sadovyak@gmail.com>
+
+#include "LooseQuadtree.hpp"
+
+#include "entity/Cell.hpp"
+
+#include <bit>
+#include <cmath>
+
+void LooseQuadtree::resize(uint32_t width, uint32_t height, uint8_t power)
+{
+  m_width = width;
+  m_height = height;
+  auto size = std::max(width, height);
+  m_rootShift = static_cast<uint8_t>(std::bit_width(size - 1));
+  power = std::min(power, m_rootShift);
+  m_levels.clear();
+  uint32_t nodes = 0;
+  for (auto shift = m_rootShift; ; --shift) {
+    Level level;
+    level.firstNode = nodes;
+    level.side = (size + (1u << shift) - 1) >> shift;
+    level.shift = shift;
+    m_levels.push_back(level);
+    nodes += level.side * level.side;
+    if (shift == power) {
+      break;
+    }
+  }
+  m_nodes.clear();
+  m_nodes.resize(nodes);
+  m_size = 0;
+}
+
+void LooseQuadtree::insert(Cell* cell, const Circle& bounds)
+{
+  attach(getNode(bounds), cell, bounds);
+  ++m_size;
+}
+
+void LooseQuadtree::erase(Cell* cell)
+{
+  auto& slot = cell->quadtreeSlot;
+  if (slot.empty()) {
+    return;
+  }
+  detach(slot.node, slot.index);
+  slot.node = QuadtreeSlot::None;
+  --m_size;
+}
+
+void LooseQuadtree::update(Cell* cell, const Circle& bounds)
+{
+  auto& slot = cell->quadtreeSlot;
+  if (slot.empty()) {
+    insert(cell, bounds);
+    return;
+  }
+  auto node = getNode(bounds);
+  if (node == slot.node) {
+    m_nodes[node].bounds[slot.index] = bounds;
+    return;
+  }
+  detach(slot.node, slot.index);
+  attach(node, cell, bounds);
+}
+
+size_t LooseQuadtree::count(const AABB& box) const
+{
+  size_t cnt = 0;
+  for (const auto& level : m_levels) {
+    if (!level.count) {
+      continue;
+    }
+    const auto& range = getRange(level, box);
+    for (auto row = range.rowStart; row <= range.rowEnd; ++row) {
+      for (auto col = range.colStart; col <= range.colEnd; ++col) {
+        const Node& node = m_nodes[level.firstNode + row * level.side + col];
+        const auto size = node.bounds.size();
+        for (size_t i = 0; i < size; ++i) {
+          if (geometry::intersects(box, node.bounds[i].position) && !node.cells[i]->zombie) {
+            ++cnt;
+          }
+        }
+      }
+    }
+  }
+  return cnt;
+}
+
+uint32_t LooseQuadtree::getNode(const Circle& bounds) const
+{
+  auto diameter = static_cast<uint32_t>(std::ceil(2 * bounds.radius));
+  auto shift = diameter > 1 ? static_cast<uint8_t>(std::bit_width(diameter - 1)) : 0;
+  auto depth = m_rootShift > shift ? m_rootShift - shift : 0;
+  const auto& level = m_levels[std::min<size_t>(depth, m_levels.size() - 1)];
+  auto x = static_cast<uint32_t>(std::clamp(bounds.position.x, 0.0f, static_cast<float>(m_width - 1)));
+  auto y = static_cast<uint32_t>(std::clamp(bounds.position.y, 0.0f, static_cast<float>(m_height - 1)));
+  return level.firstNode + (y >> level.shift) * level.side + (x >> level.shift);
+}
+
+uint32_t LooseQuadtree::getLevel(uint32_t node) const
+{
+  auto it = std::upper_bound(m_levels.begin(), m_levels.end(), node,
+    [](uint32_t value, const Level& level) { return value < level.firstNode; }
+  );
+  return static_cast<uint32_t>(it - m_levels.begin() - 1);
+}
+
+LooseQuadtree::Range LooseQuadtree::getRange(const Level& level, const AABB& box)
+{
+  // members may stick out of their node by half the node size
+  const float size = static_cast<float>(1u << level.shift);
+  const float margin = size / 2;
+  const auto max = static_cast<float>(level.side - 1);
+  Range range;
+  range.rowStart = static_cast<uint32_t>(std::clamp(std::floor((box.a.y - margin) / size), 0.0f, max));
+  range.rowEnd = static_cast<uint32_t>(std::clamp(std::floor((box.b.y + margin) / size), 0.0f, max));
+  range.colStart = static_cast<uint32_t>(std::clamp(std::floor((box.a.x - margin) / size), 0.0f, max));
+  range.colEnd = static_cast<uint32_t>(std::clamp(std::floor((box.b.x + margin) / size), 0.0f, max));
+  return range;
+}
+
+void LooseQuadtree::attach(uint32_t node, Cell* cell, const Circle& bounds)
+{
+  Node& target = m_nodes[node];
+  cell->quadtreeSlot.node = node;
+  cell->quadtreeSlot.index = static_cast<uint32_t>(target.cells.size());
+  target.cells.push_back(cell);
+  target.bounds.push_back(bounds);
+  ++m_levels[getLevel(node)].count;
+}
+
+void LooseQuadtree::detach(uint32_t node, uint32_t index)
+{
+  Node& target = m_nodes[node];
+  auto last = static_cast<uint32_t>(target.cells.size() - 1);
+  if (index != last) {
+    Cell* moved = target.cells[last];
+    target.cells[index] = moved;
+    target.bounds[index] = target.bounds[last];
+    moved->quadtreeSlot.index = index;
+  }
+  target.cells.pop_back();
+  target.bounds.pop_back();
+  --m_levels[getLevel(node)].count;
+}
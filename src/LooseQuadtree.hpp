@@ -0,0 +1,104 @@
+// file   : src/LooseQuadtree.hpp
+// author : sba <bohdan.sadovyak@gmail.com>
+
+#ifndef THEGAME_LOOSE_QUADTREE_HPP
+#define THEGAME_LOOSE_QUADTREE_HPP
+
+#include "geometry/AABB.hpp"
+#include "geometry/Circle.hpp"
+#include "geometry/geometry.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+class Cell;
+
+// Position of a cell inside LooseQuadtree: node and index of the cell in the node's arrays.
+struct QuadtreeSlot {
+  static constexpr uint32_t None {std::numeric_limits<uint32_t>::max()};
+
+  [[nodiscard]] bool empty() const { return node == None; }
+
+  uint32_t  node {None};
+  uint32_t  index {0};
+};
+
+// Loose quadtree stored as a full pyramid of levels. The root level covers the world rounded up to a power of two,
+// every next level halves the node size down to 2^power. A cell lives in exactly one node: the deepest one not
+// smaller than its diameter, picked by the cell's center. Nodes are loose by a factor of two, so a cell never sticks
+// out of its node's box expanded by half the node size, and queries widen the searched node range by that margin.
+class LooseQuadtree {
+public:
+  struct Node {
+    std::vector<Cell*>  cells;
+    std::vector<Circle> bounds;
+  };
+
+  void resize(uint32_t width, uint32_t height, uint8_t power);
+
+  void insert(Cell* cell, const Circle& bounds);
+  void erase(Cell* cell);
+  void update(Cell* cell, const Circle& bounds);
+
+  // Calls handler(Cell&) for every cell whose bounds intersect the (already clipped) box until it returns false.
+  template <typename F>
+  void query(const AABB& box, F&& handler) const;
+
+  size_t count(const AABB& box) const;
+
+  [[nodiscard]] size_t size() const { return m_size; }
+  [[nodiscard]] const std::vector<Node>& nodes() const { return m_nodes; }
+
+private:
+  struct Level {
+    uint32_t  firstNode {0};
+    uint32_t  side {0};                 // nodes per row and column
+    uint32_t  count {0};                // cells stored on the level
+    uint8_t   shift {0};                // node size is 2^shift
+  };
+
+  struct Range {
+    uint32_t  rowStart, rowEnd, colStart, colEnd;
+  };
+
+  uint32_t getNode(const Circle& bounds) const;
+  uint32_t getLevel(uint32_t node) const;
+  static Range getRange(const Level& level, const AABB& box);
+  void attach(uint32_t node, Cell* cell, const Circle& bounds);
+  void detach(uint32_t node, uint32_t index);
+
+  std::vector<Node>   m_nodes;
+  std::vector<Level>  m_levels;
+  size_t              m_size {0};
+  uint32_t            m_width {0};
+  uint32_t            m_height {0};
+  uint8_t             m_rootShift {0};
+};
+
+template <typename F>
+void LooseQuadtree::query(const AABB& box, F&& handler) const
+{
+  for (const auto& level : m_levels) {
+    if (!level.count) {
+      continue;
+    }
+    const auto& range = getRange(level, box);
+    for (auto row = range.rowStart; row <= range.rowEnd; ++row) {
+      for (auto col = range.colStart; col <= range.colEnd; ++col) {
+        const Node& node = m_nodes[level.firstNode + row * level.side + col];
+        const auto size = node.bounds.size();
+        for (size_t i = 0; i < size; ++i) {
+          if (geometry::intersects(box, node.bounds[i])) {
+            if (!handler(*node.cells[i])) {
+              return;
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+#endif /* THEGAME_LOOSE_QUADTREE_HPP */
@@ -0,0 +1,160 @@
+// file   : src/MySQLUserStorage.cpp
+// author : sba <bohdan.sadovyak@gmail.com>
+
+#include "MySQLUserStorage.hpp"
+
+#include "ScopeExit.hpp"
+
+#include <fmt/chrono.h>
+#include <mysql++/ssqls.h>
+
+#include <algorithm>
+
+sql_create_3(DboUserCreate, 1, 0,
+  mysqlpp::sql_varchar, token,
+  mysqlpp::sql_datetime, created,
+  mysqlpp::sql_int_unsigned, ip
+)
+
+sql_create_3(DboUser, 1, 0,
+  mysqlpp::sql_int_unsigned, id,
+  mysqlpp::sql_varchar, token,
+  mysqlpp::sql_int_unsigned, ip
+)
+
+MySQLUserStorage::MySQLUserStorage(MySQLConnectionPool& pool)
+  : m_mysqlConnectionPool(pool)
+{
+  DboUserCreate::table("users");
+  DboUser::table("users");
+}
+
+std::optional<UserRecord> MySQLUserStorage::findById(uint32_t id)
+{
+  mysqlpp::Connection::thread_start();
+  ScopeExit onExit([] { mysqlpp::Connection::thread_end(); });
+  mysqlpp::ScopedConnection db(m_mysqlConnectionPool, true);
+  auto query = db->query();
+  query << "SELECT id,token,ip FROM users WHERE id=" << mysqlpp::quote_only << id;
+  if (auto res = query.store(); !res.empty()) {
+    const DboUser& dbo = res[0];
+    return UserRecord {dbo.id, dbo.token, dbo.ip, {}};
+  }
+  return {};
+}
+
+std::optional<UserRecord> MySQLUserStorage::findByToken(const std::string& token)
+{
+  mysqlpp::Connection::thread_start();
+  ScopeExit onExit([] { mysqlpp::Connection::thread_end(); });
+  mysqlpp::ScopedConnection db(m_mysqlConnectionPool, true);
+  auto query = db->query();
+  query << "SELECT id,token,ip FROM users WHERE token=" << mysqlpp::quote_only << token;
+  if (auto res = query.store(); !res.empty()) {
+    const DboUser& dbo = res[0];
+    return UserRecord {dbo.id, dbo.token, dbo.ip, {}};
+  }
+  return {};
+}
+
+uint32_t MySQLUserStorage::insert(const std::string& token, uint32_t ip, SystemTimePoint created)
+{
+  mysqlpp::Connection::thread_start();
+  ScopeExit onExit([] { mysqlpp::Connection::thread_end(); });
+  mysqlpp::ScopedConnection db(m_mysqlConnectionPool, true);
+  DboUserCreate dbo;
+  dbo.token = token;
+  dbo.created = mysqlpp::String(fmt::to_string(created));
+  dbo.ip = ip;
+  auto query = db->query();
+  query.insert(dbo);
+  if (query.execute().rows()) {
+    return query.insert_id();
+  }
+  return 0;
+}
+
+std::vector<UserRecord> MySQLUserStorage::insert(std::span<const std::string> tokens, SystemTimePoint created)
+{
+  std::vector<UserRecord> result;
+  if (tokens.empty()) {
+    return result;
+  }
+  mysqlpp::Connection::thread_start();
+  ScopeExit onExit([] { mysqlpp::Connection::thread_end(); });
+  mysqlpp::ScopedConnection db(m_mysqlConnectionPool, true);
+  const auto& date = fmt::to_string(created);
+  auto query = db->query();
+  query << "INSERT INTO users (token,created,ip) VALUES ";
+  for (size_t i = 0; i < tokens.size(); ++i) {
+    query << (i ? ",(" : "(") << mysqlpp::quote << tokens[i] << "," << mysqlpp::quote << date << ",0)";
+  }
+  query.execute();
+  // the ids of a multi-row insert are not necessarily consecutive, they are read back by token
+  query.reset();
+  query << "SELECT id,token,ip FROM users WHERE token IN (";
+  for (size_t i = 0; i < tokens.size(); ++i) {
+    query << (i ? "," : "") << mysqlpp::quote << tokens[i];
+  }
+  query << ")";
+  auto res = query.store();
+  result.reserve(res.num_rows());
+  for (size_t i = 0; i < res.num_rows(); ++i) {
+    const DboUser& dbo = res[i];
+    result.push_back({dbo.id, dbo.token, dbo.ip, {}});
+  }
+  return result;
+}
+
+void MySQLUserStorage::update(std::span<const UserRecord> records)
+{
+  if (records.empty()) {
+    return;
+  }
+  mysqlpp::Connection::thread_start();
+  ScopeExit onExit([] { mysqlpp::Connection::thread_end(); });
+  mysqlpp::ScopedConnection db(m_mysqlConnectionPool, true);
+  // one statement for the whole batch instead of a round trip per user
+  auto query = db->query();
+  query << "UPDATE users SET token=CASE id";
+  for (const auto& record : records) {
+    query << " WHEN " << record.id << " THEN " << mysqlpp::quote << record.token;
+  }
+  query << " END,ip=CASE id";
+  for (const auto& record : records) {
+    query << " WHEN " << record.id << " THEN " << record.ip;
+  }
+  query << " END";
+  if (std::ranges::any_of(records, [](const auto& record) { return record.created.has_value(); })) {
+    query << ",created=CASE id";
+    for (const auto& record : records) {
+      if (record.created) {
+        query << " WHEN " << record.id << " THEN " << mysqlpp::quote << fmt::to_string(*record.created);
+      }
+    }
+    query << " ELSE created END";
+  }
+  query << " WHERE id IN (";
+  for (size_t i = 0; i < records.size(); ++i) {
+    query << (i ? "," : "") << records[i].id;
+  }
+  query << ")";
+  query.execute();
+}
+
+void MySQLUserStorage::remove(std::span<const uint32_t> ids)
+{
+  if (ids.empty()) {
+    return;
+  }
+  mysqlpp::Connection::thread_start();
+  ScopeExit onExit([] { mysqlpp::Connection::thread_end(); });
+  mysqlpp::ScopedConnection db(m_mysqlConnectionPool, true);
+  auto query = db->query();
+  query << "DELETE FROM users WHERE id IN (";
+  for (size_t i = 0; i < ids.size(); ++i) {
+    query << (i ? "," : "") << ids[i];
+  }
+  query << ")";
+  query.execute();
+}
@@ -0,0 +1,26 @@
+// file   : src/MySQLUserStorage.hpp
+// author : sba <bohdan.sadovyak@gmail.com>
+
+#ifndef THEGAME_MYSQL_USER_STORAGE_HPP
+#define THEGAME_MYSQL_USER_STORAGE_HPP
+
+#include "MySQLConnectionPool.hpp"
+#include "UserStorage.hpp"
+
+// The `users` table. Every call takes a connection of its own from the pool.
+class MySQLUserStorage final : public UserStorage {
+public:
+  explicit MySQLUserStorage(MySQLConnectionPool& pool);
+
+  std::optional<UserRecord> findById(uint32_t id) override;
+  std::optional<UserRecord> findByToken(const std::string& token) override;
+  uint32_t insert(const std::string& token, uint32_t ip, SystemTimePoint created) override;
+  std::vector<UserRecord> insert(std::span<const std::string> tokens, SystemTimePoint created) override;
+  void update(std::span<const UserRecord> records) override;
+  void remove(std::span<const uint32_t> ids) override;
+
+private:
+  MySQLConnectionPool&  m_mysqlConnectionPool;
+};
+
+#endif /* THEGAME_MYSQL_USER_STORAGE_HPP */
@@ -0,0 +1,96 @@
+// file   : src/ObjectPool.hpp
+// author : sba <bohdan.sadovyak@gmail.com>
+
+#ifndef THEGAME_OBJECT_POOL_HPP
+#define THEGAME_OBJECT_POOL_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+struct ObjectPoolStats {
+  size_t  size {0};                     // live objects
+  size_t  capacity {0};                 // slots allocated so far
+  size_t  highWater {0};                // the largest size seen
+};
+
+// Free-list allocator for objects of one type. Storage is taken from the global allocator in slabs of SlabSize slots
+// and is only returned when the pool is destroyed; destroyed objects put their slot on the free list for the next
+// create(). All objects must be destroyed before the pool. Not thread safe.
+template <typename T, size_t SlabSize = 256>
+class ObjectPool {
+public:
+  ObjectPool() = default;
+  ObjectPool(const ObjectPool&) = delete;
+  ObjectPool& operator=(const ObjectPool&) = delete;
+
+  template <typename... Args>
+  T* create(Args&&... args);
+  void destroy(T* object);
+
+  [[nodiscard]] ObjectPoolStats getStats() const { return m_stats; }
+
+private:
+  static constexpr size_t SlotSize {
+    (std::max(sizeof(T), sizeof(void*)) + alignof(T) - 1) / alignof(T) * alignof(T)
+  };
+
+  void* allocate();
+  void release(void* slot);
+
+  std::vector<std::unique_ptr<std::byte[]>> m_slabs;
+  void*                                     m_free {nullptr};
+  ObjectPoolStats                           m_stats;
+};
+
+template <typename T, size_t SlabSize>
+template <typename... Args>
+T* ObjectPool<T, SlabSize>::create(Args&&... args)
+{
+  void* slot = allocate();
+  T* object;
+  try {
+    object = new (slot) T(std::forward<Args>(args)...);
+  } catch (...) {
+    release(slot);
+    throw;
+  }
+  m_stats.highWater = std::max(m_stats.highWater, ++m_stats.size);
+  return object;
+}
+
+template <typename T, size_t SlabSize>
+void ObjectPool<T, SlabSize>::destroy(T* object)
+{
+  object->~T();
+  release(object);
+  --m_stats.size;
+}
+
+template <typename T, size_t SlabSize>
+void* ObjectPool<T, SlabSize>::allocate()
+{
+  static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+  if (!m_free) {
+    auto& slab = m_slabs.emplace_back(std::make_unique_for_overwrite<std::byte[]>(SlotSize * SlabSize));
+    for (size_t i = SlabSize; i-- > 0; ) {
+      release(slab.get() + i * SlotSize);
+    }
+    m_stats.capacity += SlabSize;
+  }
+  void* slot = m_free;
+  m_free = *static_cast<void**>(slot);
+  return slot;
+}
+
+template <typename T, size_t SlabSize>
+void ObjectPool<T, SlabSize>::release(void* slot)
+{
+  *static_cast<void**>(slot) = m_free;
+  m_free = slot;
+}
+
+#endif /* THEGAME_OBJECT_POOL_HPP */
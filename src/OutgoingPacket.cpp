@@ -5,6 +5,7 @@
 
 #include "serialization.hpp"
 
+#include "Deflater.hpp"
 #include "Player.hpp"
 
 namespace OutgoingPacket {
@@ -116,4 +117,18 @@ void serializeChangeTargetPlayer(Buffer& buffer, uint32_t playerId)
   serialize(buffer, playerId);
 }
 
+void serializeCompressed(Buffer& buffer, const Buffer& packet, Deflater& deflater)
+{
+  serialize(buffer, Type::Compressed);
+  serialize(buffer, static_cast<uint32_t>(packet.size()));
+  // the compressed size makes the packet self-delimiting, so more packets can follow it in the same message
+  auto sizeOffset = buffer.size();
+  serialize(buffer, uint32_t {0});
+  deflater.compress(packet.data(), packet.size(), buffer);
+  auto compressedSize = boost::endian::native_to_big(
+    static_cast<uint32_t>(buffer.size() - sizeOffset - sizeof(uint32_t))
+  );
+  std::memcpy(buffer.data() + sizeOffset, &compressedSize, sizeof(compressedSize));
+}
+
 } // namespace OutgoingPacket
\ No newline at end of file
@@ -8,6 +8,8 @@
 
 #include "PlayerFwd.hpp"
 
+class Deflater;
+
 namespace OutgoingPacket {
 
 enum class Type : uint8_t {
@@ -27,6 +29,7 @@ enum class Type : uint8_t {
   Finish = 14,
   ChatMessage = 15,
   ChangeTargetPlayer = 16,
+  Compressed = 17,
 };
 
 void serializePong(Buffer& buffer);
@@ -45,6 +48,8 @@ void serializeSpectate(Buffer& buffer, const Player& player);
 void serializeFinish(Buffer& buffer);
 void serializeChatMessage(Buffer& buffer, uint32_t playerId, const std::string& text);
 void serializeChangeTargetPlayer(Buffer& buffer, uint32_t playerId);
+// The packet's size (uint32) and its raw deflate; the client inflates it and handles the packet inside.
+void serializeCompressed(Buffer& buffer, const Buffer& packet, Deflater& deflater);
 
 } // namespace OutgoingPacket
 
@@ -0,0 +1,76 @@
+// file   : src/ParallelFor.cpp
+// author : sba <bohdan.sadovyak@gmail.com>
+
+#include "ParallelFor.hpp"
+
+#include <boost/asio/post.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <mutex>
+
+namespace {
+
+// Shared with the helpers, which may start after parallelFor has returned: fn is only called for a claimed index,
+// and parallelFor does not return before every claimed index is done.
+struct Loop {
+  Loop(size_t count, const std::function<void(size_t)>& fn) : count(count), fn(&fn) {}
+
+  void run()
+  {
+    for (auto i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+      try {
+        (*fn)(i);
+      } catch (...) {
+        std::lock_guard lock(mutex);
+        if (!error) {
+          error = std::current_exception();
+        }
+      }
+      if (done.fetch_add(1) + 1 == count) {
+        done.notify_all();
+      }
+    }
+  }
+
+  const size_t                        count;
+  const std::function<void(size_t)>*  fn;
+  std::atomic<size_t>                 next {0};
+  std::atomic<size_t>                 done {0};
+  std::mutex                          mutex;
+  std::exception_ptr                  error;
+};
+
+} // namespace
+
+void parallelFor(
+  const asio::any_io_executor& executor,
+  size_t count,
+  uint32_t workers,
+  const std::function<void(size_t)>& fn
+)
+{
+  if (workers <= 1 || count <= 1) {
+    for (size_t i = 0; i < count; ++i) {
+      fn(i);
+    }
+    return;
+  }
+
+  auto loop = std::make_shared<Loop>(count, fn);
+  auto helpers = std::min<size_t>(workers - 1, count - 1);
+  for (size_t i = 0; i < helpers; ++i) {
+    asio::post(executor, [loop] { loop->run(); });
+  }
+  loop->run();
+  for (auto done = loop->done.load(); done < count; done = loop->done.load()) {
+    loop->done.wait(done);
+  }
+
+  std::lock_guard lock(loop->mutex);
+  if (loop->error) {
+    std::rethrow_exception(loop->error);
+  }
+}
@@ -0,0 +1,26 @@
+// file   : src/ParallelFor.hpp
+// author : sba <bohdan.sadovyak@gmail.com>
+
+#ifndef THEGAME_PARALLEL_FOR_HPP
+#define THEGAME_PARALLEL_FOR_HPP
+
+#include <boost/asio/any_io_executor.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace asio = boost::asio;
+
+// Calls fn(i) for every i in [0, count) on up to `workers` threads: the calling one and helpers posted to the
+// executor, each taking the next index until none is left. Returns when all calls have finished; the first exception
+// thrown by fn is rethrown then. The caller works through the indices too and never waits for a helper that has not
+// started, so a pool whose threads are all busy just makes the loop serial instead of blocking it.
+void parallelFor(
+  const asio::any_io_executor& executor,
+  size_t count,
+  uint32_t workers,
+  const std::function<void(size_t)>& fn
+);
+
+#endif /* THEGAME_PARALLEL_FOR_HPP */
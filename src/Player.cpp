@@ -3,6 +3,8 @@
 
 #include "Player.hpp"
 
+#include "BufferPool.hpp"
+#include "FrameCache.hpp"
 #include "OutgoingPacket.hpp"
 #include "Room.hpp"
 #include "Session.hpp"
@@ -14,6 +16,21 @@
 
 #include <spdlog/spdlog.h>
 
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// Sector boxes are inclusive integer boxes, while a cell is homed in the sector its coordinates truncate to: a query
+// must reach right up to the next sector, or a food between two boxes is found in neither.
+AABB getExtent(const Sector& sector)
+{
+  const auto& box = sector.box;
+  return {box.a, Vec2D(std::nextafter(box.b.x + 1, box.b.x), std::nextafter(box.b.y + 1, box.b.y))};
+}
+
+} // namespace
+
 Player::Player(
   const asio::any_io_executor& executor,
   IEntityFactory& entityFactory,
@@ -29,6 +46,7 @@ Player::Player(
   , m_config(config)
   , m_gridmap(entityFactory.getGridmap())
   , m_id(id)
+  , m_deltaEncoder(DeltaEncoder::getStep(config.width, config.height))
 {
   wakeUp();
 }
@@ -104,7 +122,7 @@ void Player::respawn()
   wakeUp();
 
   if (m_mainSession) {
-    const auto& buffer = std::make_shared<Buffer>();
+    const auto& buffer = makeBuffer();
     OutgoingPacket::serializePlay(*buffer, *this);
     m_mainSession->send(buffer);
   }
@@ -152,7 +170,7 @@ void Player::addSession(const SessionPtr& sess)
     m_leftTopSector = nullptr;
     m_rightBottomSector = nullptr;
     m_sectors.clear();
-    m_visibleIds.clear();
+    m_visibleCells.clear();
   }
 }
 
@@ -181,7 +199,7 @@ void Player::setTargetPlayer(const PlayerPtr& player)
 {
   if (player.get() != this && m_targetPlayer.lock() != player) {
     m_targetPlayer = player;
-    const auto& buffer = std::make_shared<Buffer>();
+    const auto& buffer = makeBuffer();
     OutgoingPacket::serializeChangeTargetPlayer(*buffer, player->getId());
     for (const auto& session : m_sessions) {
       session->send(buffer);
@@ -239,8 +257,19 @@ void Player::split(const Vec2D& point)
   }
 }
 
-void Player::synchronize(const std::unordered_set<Cell*>& modified, const std::vector<uint32_t>& removed)
+void Player::synchronize(const FrameCache& frames, const std::vector<uint32_t>& removed)
 {
+  // The gridmap was rebuilt with another sector size: the sectors in view are gone, and what the sessions have is
+  // checked against the new ones below.
+  bool rebuilt = false;
+  if (m_gridmapGeneration != m_gridmap.getGeneration()) {
+    m_gridmapGeneration = m_gridmap.getGeneration();
+    m_leftTopSector = nullptr;
+    m_rightBottomSector = nullptr;
+    m_sectors.clear();
+    rebuilt = true;
+  }
+
   AABB viewport(m_gridmap.clip(m_viewport));
   auto* leftTop = m_gridmap.getSector(viewport.a);
   auto* rightBottom = m_gridmap.getSector(viewport.b);
@@ -261,7 +290,19 @@ void Player::synchronize(const std::unordered_set<Cell*>& modified, const std::v
     return;
   }
 
-  std::unordered_set<Cell*> syncCells;
+  // A session that fell behind dropped frames, so the client's state is unknown: forget what was sent and send
+  // everything in view, flagged for the client to drop its cells first.
+  bool reset = false;
+  for (const auto& session : m_sessions) {
+    reset |= session->takeResync();
+  }
+  if (reset) {
+    m_sectors.clear();
+    m_visibleCells.clear();
+    sectorsChanged = true;
+  }
+
+  std::unordered_set<Cell*> enteredCells; // unmodified cells of the sectors that came into view
   std::unordered_set<uint32_t> removedIds;
 
   if (sectorsChanged) {
@@ -270,11 +311,12 @@ void Player::synchronize(const std::unordered_set<Cell*>& modified, const std::v
       [&](Sector* sector)
       {
         if (sectors.find(sector) == sectors.end()) {
-          for (Cell* cell : sector->cells) {
-            if (!cell->intersects(m_viewbox)) {
-              removedIds.insert(cell->id);
+          m_gridmap.query(getExtent(*sector), [&](Cell& cell) {
+            if (!cell.intersects(m_viewbox) && m_visibleCells.erase(cell.id)) {
+              removedIds.insert(cell.id);
             }
-          }
+            return true;
+          });
           return true;
         }
         return false;
@@ -283,17 +325,37 @@ void Player::synchronize(const std::unordered_set<Cell*>& modified, const std::v
     for (Sector* sector : sectors) {
       const auto& res = m_sectors.insert(sector);
       if (res.second) {
-        syncCells.insert(sector->cells.begin(), sector->cells.end());
+        m_gridmap.query(getExtent(*sector), [&](Cell& cell) {
+          if (!frames.isModified(&cell)) {
+            enteredCells.insert(&cell);
+          }
+          return true;
+        });
       }
     }
   }
-  for (Cell* cell : modified) {
-    if (cell->player == this || cell->intersects(m_viewbox)) {
-      syncCells.insert(cell);
+  if (rebuilt) {
+    // every sector in view has just entered; the cells sent before that are not in them any more are removed
+    std::unordered_set<uint32_t> inView;
+    for (Sector* sector : m_sectors) {
+      m_gridmap.query(getExtent(*sector), [&](Cell& cell) {
+        inView.insert(cell.id);
+        return true;
+      });
     }
+    for (const Avatar* avatar : m_avatars) {
+      inView.insert(avatar->id);
+    }
+    std::erase_if(m_visibleCells, [&](const auto& item) {
+      if (inView.contains(item.first)) {
+        return false;
+      }
+      removedIds.insert(item.first);
+      return true;
+    });
   }
   for (auto id : removed) {
-    if (m_visibleIds.erase(id)) {
+    if (m_visibleCells.erase(id)) {
       removedIds.insert(id);
     }
   }
@@ -302,13 +364,15 @@ void Player::synchronize(const std::unordered_set<Cell*>& modified, const std::v
     Scale = 1,
     SyncCells = 2,
     RemovedIds = 4,
-    DirectionToTargetPlayer = 8
+    DirectionToTargetPlayer = 8,
+    DeltaCells = 16,
+    Reset = 32
   };
 
   uint8_t flags = Scale; // TODO: implement
 
-  if (!syncCells.empty()) {
-    flags |= SyncCells;
+  if (reset) {
+    flags |= Reset;
   }
 
   if (!removedIds.empty()) {
@@ -325,19 +389,78 @@ void Player::synchronize(const std::unordered_set<Cell*>& modified, const std::v
     }
   }
 
-  const auto& buffer = std::make_shared<Buffer>();
+  // frames change little from tick to tick, so the last one's size saves growing the buffer while it is written
+  const auto& buffer = makeBuffer(m_frameSize);
   serialize(*buffer, OutgoingPacket::Type::Frame);
-  serialize(*buffer, flags);
+  auto flagsOffset = buffer->size();
+  serialize(*buffer, flags); // SyncCells is known only after the cells are written
   if (flags & Scale) {
     serialize(*buffer, m_scale);
   }
-  if (flags & SyncCells) {
-    serialize(*buffer, static_cast<uint16_t>(syncCells.size()));
-    for (Cell* cell: syncCells) {
-      cell->format(*buffer);
-      m_visibleIds.insert(cell->id);
+
+  // Modified cells come from the frame cache: the ones homed in the viewport sectors, row by row, then the ones
+  // reaching into the viewbox from outside and the player's own avatars out of view. They are copied encoded as full
+  // records (SyncCells), or written as changes against what the sessions already have (DeltaCells).
+  const bool delta = m_config.player.deltaFrames;
+  auto sectionOffset = buffer->size();
+  if (delta) {
+    m_deltaEncoder.begin(*buffer, m_viewbox.a);
+  }
+  auto countOffset = buffer->size();
+  serialize(*buffer, uint16_t{0});
+  size_t count = 0;
+  auto write = [&](Cell& cell) {
+    auto [it, inserted] = m_visibleCells.try_emplace(cell.id);
+    if (delta) {
+      count += m_deltaEncoder.encode(*buffer, cell, it->second, inserted);
+    } else {
+      cell.format(*buffer);
+      ++count;
+    }
+  };
+  auto append = [&](FrameCache::Records records) {
+    if (delta) {
+      for (const auto& record : records) {
+        write(*record.cell);
+      }
+      return;
+    }
+    frames.append(*buffer, records);
+    for (const auto& record : records) {
+      m_visibleCells.try_emplace(record.cell->id);
+    }
+    count += records.size();
+  };
+  SectorRange range;
+  const bool inView = m_gridmap.getSectorRange(viewport, range);
+  if (inView) {
+    for (auto row = range.rowStart; row <= range.rowEnd; ++row) {
+      append(frames.getRow(row, range.colStart, range.colEnd));
     }
+    for (const auto& record : frames.getBorder()) {
+      if (!frames.isInside(record, range) && record.cell->intersects(m_viewbox)) {
+        append({&record, 1});
+      }
+    }
+  }
+  for (const auto& record : frames.getOwned(this)) {
+    // an avatar homed in the viewport sectors is in their rows even if it does not reach into the viewbox
+    if ((!inView || !frames.isInside(record, range)) && !record.cell->intersects(m_viewbox)) {
+      append({&record, 1});
+    }
+  }
+  for (Cell* cell : enteredCells) {
+    write(*cell);
   }
+  if (count) {
+    flags |= delta ? DeltaCells : SyncCells;
+    auto value = boost::endian::native_to_big(static_cast<uint16_t>(count));
+    std::memcpy(buffer->data() + countOffset, &value, sizeof(value));
+  } else {
+    buffer->resize(sectionOffset);
+  }
+  (*buffer)[flagsOffset] = static_cast<char>(flags);
+
   if (flags & RemovedIds) {
     serialize(*buffer, static_cast<uint16_t>(removedIds.size()));
     for (auto id: removedIds) {
@@ -352,13 +475,11 @@ void Player::synchronize(const std::unordered_set<Cell*>& modified, const std::v
   if (flags & DirectionToTargetPlayer) {
     serialize(*buffer, m_directionToTargetPlayer);
   }
+  m_frameSize = buffer->size();
 
   for (const auto& session : m_sessions) {
-    session->send(buffer);
+    session->sendFrame(buffer, reset);
   }
-
-  syncCells.clear();
-  removedIds.clear();
 }
 
 void Player::wakeUp()
@@ -584,7 +705,7 @@ void Player::onDeath()
   if (!observable || observable->isDead()) {
     observable = m_entityFactory.getTopPlayer();
   }
-  const auto& buffer = std::make_shared<Buffer>();
+  const auto& buffer = makeBuffer();
   if (!observable || observable->isDead()) {
     OutgoingPacket::serializeFinish(*buffer);
   } else {
@@ -4,6 +4,7 @@
 #ifndef THEGAME_PLAYER_HPP
 #define THEGAME_PLAYER_HPP
 
+#include "DeltaEncoder.hpp"
 #include "EventEmitter.hpp"
 #include "Gridmap.hpp"
 #include "IEntityFactory.hpp"
@@ -26,6 +27,7 @@ namespace config {
 }
 
 class Avatar;
+class FrameCache;
 
 class Player : public std::enable_shared_from_this<Player> {
 public:
@@ -54,7 +56,7 @@ public:
   void setTargetPlayer(const PlayerPtr& player);
   void eject(const Vec2D& point);
   void split(const Vec2D& point);
-  void synchronize(const std::unordered_set<Cell*>& modified, const std::vector<uint32_t>& removed);
+  void synchronize(const FrameCache& frames, const std::vector<uint32_t>& removed);
   void wakeUp();
   void calcParams(); // TODO: optimize using
   void applyPointerForce();
@@ -79,7 +81,6 @@ protected:
   void onDeath();
 
   using Avatars = std::unordered_set<Avatar*>;
-  using VisibleIds = std::unordered_set<uint32_t>;
 
   struct Status {
     bool isOnline : 1 {false};
@@ -101,7 +102,8 @@ protected:
   Sessions              m_sessions;
   SessionPtr            m_mainSession;
   Avatars               m_avatars;
-  VisibleIds            m_visibleIds;
+  ClientCells           m_visibleCells;       // what the sessions were sent, by id
+  DeltaEncoder          m_deltaEncoder;
   std::set<Sector*>     m_sectors;
   AABB                  m_viewport;
   AABB                  m_viewbox;
@@ -109,6 +111,7 @@ protected:
   Vec2D                 m_pointerOffset;
   Sector*               m_leftTopSector {nullptr};
   Sector*               m_rightBottomSector {nullptr};
+  uint32_t              m_gridmapGeneration {0};  // of the sectors above
   PlayerWPtr            m_targetPlayer;
   PlayerWPtr            m_killer;
   uint32_t              m_mass {0};
@@ -116,6 +119,7 @@ protected:
   float                 m_scale {0};
   uint8_t               m_color {0};
   uint8_t               m_directionToTargetPlayer {0};
+  size_t                m_frameSize {0};
   Status                m_status;
 
   friend bool operator<(const Player& l, const Player& r);
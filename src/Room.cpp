@@ -4,6 +4,8 @@
 #include "Room.hpp"
 
 #include "OutgoingPacket.hpp"
+#include "BufferPool.hpp"
+#include "ParallelFor.hpp"
 #include "Session.hpp"
 #include "Player.hpp"
 #include "Bot.hpp"
@@ -25,8 +27,9 @@
 
 using namespace std::placeholders;
 
-Room::Room(asio::any_io_executor executor, uint32_t id)
+Room::Room(asio::any_io_executor executor, asio::any_io_executor workers, uint32_t id)
   : m_executor(std::move(executor))
+  , m_workers(std::move(workers))
   , m_updateTimer(m_executor, [this] { update(); })
   , m_syncTimer(m_executor, [this] { synchronize(); })
   , m_updateLeaderboardTimer(m_executor, [this] { updateLeaderboard(); })
@@ -37,6 +40,7 @@ Room::Room(asio::any_io_executor executor, uint32_t id)
   , m_virusGeneratorTimer(m_executor, [this] { generateViruses(); })
   , m_phageGeneratorTimer(m_executor, [this] { generatePhages(); })
   , m_motherGeneratorTimer(m_executor, [this] { generateMothers(); })
+  , m_gridmapTimer(m_executor, [this] { tuneGridmap(); })
   , m_id(id)
 {
 }
@@ -44,13 +48,17 @@ Room::Room(asio::any_io_executor executor, uint32_t id)
 Room::~Room()
 {
   for (auto* cell : m_cells) {
-    delete cell;
+    destroyCell(cell);
   }
 }
 
-void Room::init(const config::Room& config)
+void Room::init(const config::Room& config, const config::Deflate& deflate)
 {
   m_config = config;
+  m_deflate = deflate;
+  if (m_deflate.broadcastThreshold) {
+    m_deflater.emplace(m_deflate.level, m_deflate.windowBits, m_deflate.memLevel);
+  }
 
   m_updateTimer.setInterval(m_config.updateInterval);
   m_syncTimer.setInterval(m_config.syncInterval);
@@ -62,8 +70,12 @@ void Room::init(const config::Room& config)
   m_virusGeneratorTimer.setInterval(m_config.generator.virus.interval);
   m_phageGeneratorTimer.setInterval(m_config.generator.phage.interval);
   m_motherGeneratorTimer.setInterval(m_config.generator.mother.interval);
+  m_gridmapTimer.setInterval(m_config.gridmap.tuneInterval);
 
-  m_gridmap.resize(m_config.width, m_config.height, 9);
+  auto index = m_config.gridmap.index == config::Gridmap::Index::Quadtree
+    ? Gridmap::Index::Quadtree
+    : Gridmap::Index::Grid;
+  m_gridmap.resize(m_config.width, m_config.height, m_config.gridmap.power, index);
 
   generateFood(m_config.food.quantity);
   generateViruses(m_config.virus.quantity);
@@ -71,6 +83,8 @@ void Room::init(const config::Room& config)
   generateMothers(m_config.mother.quantity);
 
   createBots();
+
+  tuneGridmap();
 }
 
 void Room::start()
@@ -81,6 +95,7 @@ void Room::start()
   m_checkExpirableCellsTimer.start();
   m_updateNearbyFoodForMothersTimer.start();
   m_generateFoodByMothersTimer.start();
+  m_gridmapTimer.start();
   if (m_config.generator.food.enabled) {
     m_foodGeneratorTimer.start();
   }
@@ -107,6 +122,7 @@ void Room::stop()
   m_virusGeneratorTimer.stop();
   m_phageGeneratorTimer.stop();
   m_motherGeneratorTimer.stop();
+  m_gridmapTimer.stop();
   for (const auto& bot : m_bots) {
     bot->stop();
   }
@@ -117,6 +133,29 @@ bool Room::hasFreeSpace() const
   return m_hasFreeSpace;
 }
 
+uint32_t Room::getId() const
+{
+  return m_id;
+}
+
+Gridmap::Stats Room::getGridmapStats() const
+{
+  std::lock_guard lock(m_statsMutex);
+  return m_gridmapStats;
+}
+
+Room::PoolStats Room::getPoolStats() const
+{
+  std::lock_guard lock(m_statsMutex);
+  return m_poolStats;
+}
+
+Room::SyncStats Room::getSyncStats() const
+{
+  std::lock_guard lock(m_statsMutex);
+  return m_syncStats;
+}
+
 void Room::join(const SessionPtr& sess, uint32_t playerId)
 {
   asio::post(m_executor, std::bind_front(&Room::doJoin, this, sess, playerId));
@@ -164,7 +203,7 @@ void Room::chatMessage(const SessionPtr& sess, const std::string& text)
 
 Avatar& Room::createAvatar()
 {
-  auto* avatar = new Avatar(m_executor, *this, m_config, m_cellNextId.pop());
+  auto* avatar = m_avatarPool.create(m_executor, *this, m_config, m_cellNextId.pop());
   avatar->subscribeToDeath(this, std::bind_front(&Room::onAvatarDeath, this, avatar));
   avatar->subscribeToMassChange(this, std::bind(&Room::onAvatarMassChange, this, avatar, _1));
   avatar->subscribeToMotionStarted(this, std::bind_front(&Room::onMotionStarted, this, avatar));
@@ -175,7 +214,7 @@ Avatar& Room::createAvatar()
 
 Food& Room::createFood()
 {
-  auto* food = new Food(m_executor, *this, m_config, m_cellNextId.pop());
+  auto* food = m_foodPool.create(m_executor, *this, m_config, m_cellNextId.pop());
   food->subscribeToDeath(this, std::bind_front(&Room::onFoodDeath, this, food));
   food->subscribeToMotionStopped(this, std::bind_front(&Room::onMotionStopped, this, food));
   updateNewCellRegistries(food, RegistryModificationOptions::None);
@@ -185,7 +224,7 @@ Food& Room::createFood()
 
 Bullet& Room::createBullet()
 {
-  auto* bullet = new Bullet(m_executor, *this, m_config, m_cellNextId.pop());
+  auto* bullet = m_bulletPool.create(m_executor, *this, m_config, m_cellNextId.pop());
   bullet->subscribeToDeath(this, std::bind_front(&Room::onBulletDeath, this, bullet));
   bullet->subscribeToMotionStopped(this, std::bind_front(&Room::onMotionStopped, this, bullet));
   updateNewCellRegistries(bullet, RegistryModificationOptions::Activated);
@@ -194,7 +233,7 @@ Bullet& Room::createBullet()
 
 Virus& Room::createVirus()
 {
-  auto* virus = new Virus(m_executor, *this, m_config, m_cellNextId.pop());
+  auto* virus = m_virusPool.create(m_executor, *this, m_config, m_cellNextId.pop());
   virus->subscribeToDeath(this, std::bind_front(&Room::onVirusDeath, this, virus));
   virus->subscribeToMassChange(this, std::bind(&Room::onCellMassChange, this, virus, _1));
   virus->subscribeToMotionStarted(this, std::bind_front(&Room::onMotionStarted, this, virus));
@@ -207,7 +246,7 @@ Virus& Room::createVirus()
 
 Phage& Room::createPhage()
 {
-  auto* phage = new Phage(m_executor, *this, m_config, m_cellNextId.pop());
+  auto* phage = m_phagePool.create(m_executor, *this, m_config, m_cellNextId.pop());
   phage->subscribeToDeath(this, std::bind_front(&Room::onPhageDeath, this, phage));
   phage->subscribeToMassChange(this, std::bind(&Room::onCellMassChange, this, phage, _1));
   phage->subscribeToMotionStarted(this, std::bind_front(&Room::onMotionStarted, this, phage));
@@ -220,7 +259,7 @@ Phage& Room::createPhage()
 
 Mother& Room::createMother()
 {
-  auto* mother = new Mother(m_executor, *this, m_config, m_cellNextId.pop());
+  auto* mother = m_motherPool.create(m_executor, *this, m_config, m_cellNextId.pop());
   mother->subscribeToDeath(this, std::bind_front(&Room::onMotherDeath, this, mother));
   mother->subscribeToMassChange(this, std::bind(&Room::onMotherMassChange, this, mother, _1));
   mother->subscribeToMotionStopped(this, std::bind_front(&Room::onMotionStopped, this, mother));
@@ -275,14 +314,14 @@ PlayerPtr Room::getTopPlayer() const
   return m_topPlayer.lock();
 }
 
-asio::any_io_executor& Room::getGameExecutor()
+EventQueue& Room::getGameEvents()
 {
-  return m_gameExecutor;
+  return m_gameEvents;
 }
 
-asio::any_io_executor& Room::getDeathExecutor()
+EventQueue& Room::getDeathEvents()
 {
-  return m_deathExecutor;
+  return m_deathEvents;
 }
 
 void Room::doJoin(const SessionPtr& sess, uint32_t playerId)
@@ -293,7 +332,7 @@ void Room::doJoin(const SessionPtr& sess, uint32_t playerId)
 
   sess->playerId(playerId);
 
-  const auto& buffer = std::make_shared<Buffer>();
+  const auto& buffer = makeBuffer();
   serialize(*buffer);
 
   const auto& it = m_players.find(playerId);
@@ -387,7 +426,7 @@ void Room::doSpectate(const SessionPtr& sess, uint32_t targetId)
   if (auto observable = sess->observable()) {
     observable->removeSession(sess);
   }
-  const auto& buffer = std::make_shared<Buffer>();
+  const auto& buffer = makeBuffer();
   OutgoingPacket::serializeSpectate(*buffer, *target);
   sess->send(buffer);
   target->addSession(sess);
@@ -427,7 +466,7 @@ void Room::doChatMessage(const SessionPtr& sess, const std::string& text)
   if (!player){
     return;
   }
-  const auto& buffer = std::make_shared<Buffer>();
+  const auto& buffer = makeBuffer();
   OutgoingPacket::serializeChatMessage(*buffer, player->getId(), text);
   send(buffer);
   m_chatHistory.emplace_front(player->getId(), player->getName(), text);
@@ -443,7 +482,7 @@ void Room::recalculateFreeSpace()
 
 void Room::updateNewCellRegistries(Cell* cell, RegistryModificationOptions options)
 {
-  m_cells.insert(cell);
+  m_cells.add(cell);
   m_newCells.insert(cell);
   m_createdCells.insert(cell);
   if (options & RegistryModificationOptions::Activated) {
@@ -458,7 +497,7 @@ void Room::updateNewCellRegistries(Cell* cell, RegistryModificationOptions optio
 void Room::prepareCellForDestruction(Cell* cell)
 {
   m_deadCells.push_back(cell);
-  m_processingCells.erase(cell);
+  m_cells.stopMotion(cell);
   m_forRandomPositionCheck.erase(cell);
   m_newCells.erase(cell);
   m_createdCells.erase(cell);
@@ -471,8 +510,34 @@ void Room::removeCell(Cell* cell)
 {
   m_mass -= cell->mass;
   m_cellNextId.push(cell->id);
-  m_cells.erase(cell);
-  delete cell;
+  m_cells.remove(cell);
+  destroyCell(cell);
+}
+
+void Room::destroyCell(Cell* cell)
+{
+  switch (cell->type) {
+    case Cell::typeAvatar:
+      m_avatarPool.destroy(static_cast<Avatar*>(cell));
+      break;
+    case Cell::typeFood:
+      m_foodPool.destroy(static_cast<Food*>(cell));
+      break;
+    case Cell::typeMass:
+      m_bulletPool.destroy(static_cast<Bullet*>(cell));
+      break;
+    case Cell::typeVirus:
+      m_virusPool.destroy(static_cast<Virus*>(cell));
+      break;
+    case Cell::typePhage:
+      m_phagePool.destroy(static_cast<Phage*>(cell));
+      break;
+    case Cell::typeMother:
+      m_motherPool.destroy(static_cast<Mother*>(cell));
+      break;
+    default:
+      spdlog::error("Room {}: unknown cell type {}", m_id, cell->type);
+  }
 }
 
 void Room::resolveCellPosition(Cell& cell)
@@ -554,6 +619,7 @@ void Room::update()
   auto now{TimePoint::clock::now()};
   double dt = std::chrono::duration_cast<std::chrono::duration<double>>(now - m_lastUpdate).count();
   m_lastUpdate = now;
+  m_time += dt;
 
   handlePlayerRequests();
 
@@ -563,73 +629,123 @@ void Room::update()
   }
 
   if (!m_createdCells.empty()) {
-    for (auto* cell: m_createdCells) {
+    for (auto* cell: m_createdCells.cells()) {
       resolveCellPosition(*cell);
       m_gridmap.insert(cell);
       if (cell->velocity) {
-        m_processingCells.insert(cell);
+        m_cells.startMotion(cell);
       }
     }
     m_createdCells.clear();
   }
 
   if (!m_activatedCells.empty()) {
-    m_processingCells.insert(m_activatedCells.begin(), m_activatedCells.end());
+    for (auto* cell : m_activatedCells.cells()) {
+      m_cells.startMotion(cell);
+    }
     m_activatedCells.clear();
   }
 
-  for (auto* cell : m_processingCells) {
-    cell->applyResistanceForce();
-    if (cell->force) {
+  const auto& moving = m_cells.moving();
+  const auto threshold = m_config.deadReckoningThreshold;
+  m_cells.integrate(dt);
+  for (size_t row = 0; row < moving.size(); ++row) {
+    auto* cell = moving[row];
+    // with dead reckoning a cell is resent only when the clients' extrapolation of it drifts too far; bounces, stops
+    // and mass changes still mark it modified
+    if (m_cells.forced(row) && (!threshold || !cell->isPredictable(m_time, threshold))) {
       m_modifiedCells.insert(cell);
     }
-    cell->simulate(dt);
+    if (m_cells.stopped(row)) {
+      cell->stopMotion();
+    }
     resolveCellPosition(*cell);
     m_gridmap.update(cell);
   }
 
-  for (auto* cell : m_processingCells) {
-    if (!cell->zombie) {
-      m_gridmap.query(cell->getAABB(), [cell](Cell& target) -> bool {
-        if (cell != &target && !cell->zombie && !target.zombie) {
-          cell->interact(target);
+  m_gridmap.collectPairs(moving, m_collisionPairs);
+  for (const auto& [cell, target] : m_collisionPairs) {
+    if (!cell->zombie && !target->zombie) {
+      cell->interact(*target);
+    }
+  }
+
+  for (auto* cell : moving) {
+    auto reach = cell->zombie ? 0 : cell->getFoodReach();
+    if (reach > 0) {
+      // only food centered under the cell's AABB, as when food was paired through the cell's query
+      m_gridmap.queryPoints(Circle(cell->position, reach), cell->getAABB(), [cell](Cell& food) {
+        if (!food.zombie) {
+          cell->interact(static_cast<Food&>(food));
         }
         return !cell->zombie;
       });
     }
   }
 
-  m_gameContext.run();
-  m_gameContext.restart();
-  m_deathContext.run();
-  m_deathContext.restart();
+  m_gameEvents.flush();
+  m_deathEvents.flush();
 }
 
 void Room::synchronize()
 {
+  using Clock = std::chrono::steady_clock;
+  auto start = Clock::now();
+
   std::vector<uint32_t> removedCellIds;
   removedCellIds.reserve(m_deadCells.size());
   for (auto* cell : m_deadCells) {
     removedCellIds.push_back(cell->id);
   }
 
+  m_frameCache.build(m_gridmap, m_modifiedCells, !m_config.player.deltaFrames);
+  for (auto* cell : m_modifiedCells.cells()) {
+    cell->syncPosition = cell->position;
+    cell->syncVelocity = cell->velocity;
+    cell->syncTime = m_time;
+  }
+  auto prepared = Clock::now();
+
+  // a frame reads the position of the player it points to, so all of them are updated before any frame is built
+  m_syncPlayers.clear();
   for (const auto& player : m_fighters) {
     player->calcParams();
-    player->synchronize(m_modifiedCells, removedCellIds);
+    m_syncPlayers.push_back(player.get());
   }
+  auto paramsDone = Clock::now();
+
+  // frames only read the world and write their own player's state; the room waits for all of them before cells die
+  parallelFor(m_workers, m_syncPlayers.size(), m_config.syncWorkers, [&](size_t i) {
+    m_syncPlayers[i]->synchronize(m_frameCache, removedCellIds);
+  });
+  auto framesDone = Clock::now();
   m_modifiedCells.clear();
 
   std::erase_if(m_fighters, [&](const auto& player) { return player->isDead(); });
 
-  for (auto* cell : m_newCells) {
+  for (auto* cell : m_newCells.cells()) {
     cell->newly = false;
   }
   m_newCells.clear();
 
+  // the registries still list the dead cells erased from them, drop the entries before the cells are destroyed
+  m_createdCells.compact();
+  m_activatedCells.compact();
+
   for (auto* cell : m_deadCells) {
     removeCell(cell);
   }
   m_deadCells.clear();
+
+  auto finish = Clock::now();
+  auto elapsed = [](auto from, auto to) { return std::chrono::duration_cast<SyncStats::Duration>(to - from); };
+  ++m_syncTimes.count;
+  m_syncTimes.players = static_cast<uint32_t>(m_syncPlayers.size());
+  m_syncTimes.prepare += elapsed(start, prepared);
+  m_syncTimes.params += elapsed(prepared, paramsDone);
+  m_syncTimes.frames += elapsed(paramsDone, framesDone);
+  m_syncTimes.cleanup += elapsed(framesDone, finish);
+  m_syncTimes.maxTotal = std::max(m_syncTimes.maxTotal, elapsed(start, finish));
 }
 
 void Room::updateLeaderboard()
@@ -641,7 +757,7 @@ void Room::updateLeaderboard()
       std::sort(m_leaderboard.begin(), m_leaderboard.end(), [](const auto& a, const auto& b) { return *b < *a; });
       m_topPlayer = m_leaderboard[0];
     }
-    const auto& buffer = std::make_shared<Buffer>();
+    const auto& buffer = makeBuffer();
     OutgoingPacket::serializeLeaderboard(*buffer, m_leaderboard, m_config.leaderboard.limit);
     send(buffer);
     m_updateLeaderboard = false;
@@ -657,6 +773,44 @@ void Room::removeFromLeaderboard(const PlayerPtr& player)
   }
 }
 
+void Room::tuneGridmap()
+{
+  const auto& config = m_config.gridmap;
+  if (config.autoTune) {
+    auto power = m_gridmap.suggestPower(m_cells.moving(), config.minPower, config.maxPower);
+    if (power != m_gridmap.getPower()) {
+      spdlog::info("Room {}: gridmap sector power {} -> {}", m_id, m_gridmap.getPower(), power);
+      m_gridmap.rebuild(power);
+    }
+  }
+  updateStats();
+}
+
+void Room::updateStats()
+{
+  auto stats = m_gridmap.getStats();
+  PoolStats poolStats {{
+    {"avatar", m_avatarPool.getStats()},
+    {"food", m_foodPool.getStats()},
+    {"bullet", m_bulletPool.getStats()},
+    {"virus", m_virusPool.getStats()},
+    {"phage", m_phagePool.getStats()},
+    {"mother", m_motherPool.getStats()}
+  }};
+  auto syncStats = m_syncTimes;
+  if (syncStats.count) {
+    syncStats.prepare /= syncStats.count;
+    syncStats.params /= syncStats.count;
+    syncStats.frames /= syncStats.count;
+    syncStats.cleanup /= syncStats.count;
+  }
+  m_syncTimes = {};
+  std::lock_guard lock(m_statsMutex);
+  m_gridmapStats = stats;
+  m_poolStats = poolStats;
+  m_syncStats = syncStats;
+}
+
 void Room::updateNearbyFoodForMothers()
 {
   for (auto* mother : m_mothers) {
@@ -820,49 +974,61 @@ void Room::serialize(Buffer& buffer)
 
 void Room::send(const BufferPtr& buffer)
 {
+  if (m_sessions.empty()) {
+    return;
+  }
+  // compressed once here rather than by every session's websocket deflate
+  auto packet = buffer;
+  if (m_deflater && buffer->size() >= m_deflate.broadcastThreshold) {
+    auto compressed = makeBuffer(buffer->size());
+    OutgoingPacket::serializeCompressed(*compressed, *buffer, *m_deflater);
+    if (compressed->size() < buffer->size()) {
+      packet = compressed;
+    }
+  }
   for (const auto& sess : m_sessions) {
-    sess->send(buffer);
+    sess->send(packet);
   }
 }
 
 void Room::sendPacketPlayer(const Player& player)
 {
-  const auto& buffer = std::make_shared<Buffer>();
+  const auto& buffer = makeBuffer();
   OutgoingPacket::serializePlayer(*buffer, player);
   send(buffer);
 }
 
 void Room::sendPacketPlayerRemove(uint32_t playerId)
 {
-  const auto& buffer = std::make_shared<Buffer>();
+  const auto& buffer = makeBuffer();
   OutgoingPacket::serializePlayerRemove(*buffer, playerId);
   send(buffer);
 }
 
 void Room::sendPacketPlayerJoin(uint32_t playerId)
 {
-  const auto& buffer = std::make_shared<Buffer>();
+  const auto& buffer = makeBuffer();
   OutgoingPacket::serializePlayerJoin(*buffer, playerId);
   send(buffer);
 }
 
 void Room::sendPacketPlayerLeave(uint32_t playerId)
 {
-  const auto& buffer = std::make_shared<Buffer>();
+  const auto& buffer = makeBuffer();
   OutgoingPacket::serializePlayerLeave(*buffer, playerId);
   send(buffer);
 }
 
 void Room::sendPacketPlayerBorn(uint32_t playerId)
 {
-  const auto& buffer = std::make_shared<Buffer>();
+  const auto& buffer = makeBuffer();
   OutgoingPacket::serializePlayerBorn(*buffer, playerId);
   send(buffer);
 }
 
 void Room::sendPacketPlayerDead(uint32_t playerId)
 {
-  const auto& buffer = std::make_shared<Buffer>();
+  const auto& buffer = makeBuffer();
   OutgoingPacket::serializePlayerDead(*buffer, playerId);
   send(buffer);
 }
@@ -932,13 +1098,13 @@ void Room::onMotherDeath(Mother* mother)
 
 void Room::onMotionStarted(Cell* cell)
 {
-  m_processingCells.insert(cell);
+  m_cells.startMotion(cell);
   m_modifiedCells.insert(cell);
 }
 
 void Room::onMotionStopped(Cell* cell)
 {
-  m_processingCells.erase(cell);
+  m_cells.stopMotion(cell);
   m_modifiedCells.insert(cell);
 }
 
@@ -946,6 +1112,9 @@ void Room::onCellMassChange(Cell* cell, float deltaMass)
 {
   m_mass += deltaMass;
   m_modifiedCells.insert(cell);
+  if (m_gridmap.contains(cell)) {
+    m_gridmap.update(cell); // the radius is cached in the index, keep it in sync for non-moving cells too
+  }
 }
 
 void Room::onAvatarMassChange(Avatar* avatar, float deltaMass)
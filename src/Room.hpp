@@ -8,15 +8,26 @@
 
 #include "IEntityFactory.hpp"
 
+#include "CellRegistry.hpp"
+#include "CellStore.hpp"
 #include "ChatMessage.hpp"
 #include "Config.hpp"
+#include "Deflater.hpp"
+#include "EventQueue.hpp"
+#include "FrameCache.hpp"
 #include "Gridmap.hpp"
 #include "NextId.hpp"
+#include "ObjectPool.hpp"
 #include "Timer.hpp"
 #include "types.hpp"
 
+#include <array>
+#include <chrono>
 #include <list>
+#include <mutex>
+#include <optional>
 #include <random>
+#include <string_view>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
@@ -30,15 +41,35 @@ class Bot;
 
 class Room : public IEntityFactory {
 public:
-  Room(asio::any_io_executor executor, uint32_t id);
+  using PoolStats = std::array<std::pair<std::string_view, ObjectPoolStats>, 6>;
+
+  // Phases of synchronize(), averaged over the stats period.
+  struct SyncStats {
+    using Duration = std::chrono::microseconds;
+
+    uint32_t  count {0};                // syncs in the period
+    uint32_t  players {0};              // frames built by the last sync
+    Duration  prepare {0};              // removed ids and the frame cache
+    Duration  params {0};               // Player::calcParams
+    Duration  frames {0};               // Player::synchronize, in parallel
+    Duration  cleanup {0};              // registries and dead cells
+    Duration  maxTotal {0};
+  };
+
+  // Frames are built on `workers` (the room's thread pool) while the room's own executor waits for them.
+  Room(asio::any_io_executor executor, asio::any_io_executor workers, uint32_t id);
   ~Room() override;
 
-  void init(const config::Room& config);
+  void init(const config::Room& config, const config::Deflate& deflate = {});
 
   void start();
   void stop();
 
   bool hasFreeSpace() const;
+  uint32_t getId() const;
+  Gridmap::Stats getGridmapStats() const;
+  PoolStats getPoolStats() const;
+  SyncStats getSyncStats() const;
 
   void join(const SessionPtr& sess, uint32_t playerId);
   void leave(const SessionPtr& sess);
@@ -69,8 +100,8 @@ private:
   Vec2D getRandomDirection() const override;
   Gridmap& getGridmap() override;
   PlayerPtr getTopPlayer() const override;
-  asio::any_io_executor& getGameExecutor() override;
-  asio::any_io_executor& getDeathExecutor() override;
+  EventQueue& getGameEvents() override;
+  EventQueue& getDeathEvents() override;
 
   void doJoin(const SessionPtr& sess, uint32_t playerId);
   void doLeave(const SessionPtr& sess);
@@ -86,6 +117,7 @@ private:
   void updateNewCellRegistries(Cell* cell, RegistryModificationOptions options = RegistryModificationOptions::All);
   void prepareCellForDestruction(Cell* cell);
   void removeCell(Cell* cell);
+  void destroyCell(Cell* cell);
   void resolveCellPosition(Cell& cell);
   void killExpiredCells(); // TODO: move logic to target classes
   void handlePlayerRequests();
@@ -93,6 +125,8 @@ private:
   void synchronize();
   void updateLeaderboard();
   void removeFromLeaderboard(const PlayerPtr& player);
+  void tuneGridmap();
+  void updateStats();
   void updateNearbyFoodForMothers();
   void generateFoodByMothers();
   PlayerPtr createPlayer(uint32_t id, const std::string& name);
@@ -138,11 +172,11 @@ private:
   using Bots = std::unordered_set<std::shared_ptr<Bot>>;
 
   mutable std::random_device  m_generator;
+  mutable std::mutex          m_statsMutex;
   asio::any_io_executor       m_executor;
-  asio::io_context            m_gameContext;
-  asio::io_context            m_deathContext;
-  asio::any_io_executor       m_gameExecutor {asio::make_strand(m_gameContext)};
-  asio::any_io_executor       m_deathExecutor {asio::make_strand(m_deathContext)};
+  asio::any_io_executor       m_workers;
+  EventQueue                  m_gameEvents;
+  EventQueue                  m_deathEvents;
   Timer                       m_updateTimer;
   Timer                       m_syncTimer;
   Timer                       m_updateLeaderboardTimer; // TODO: use delayed call
@@ -153,9 +187,22 @@ private:
   Timer                       m_virusGeneratorTimer;
   Timer                       m_phageGeneratorTimer;
   Timer                       m_motherGeneratorTimer;
+  Timer                       m_gridmapTimer;
 
   config::Room                m_config;
+  config::Deflate             m_deflate;
+  std::optional<Deflater>     m_deflater;   // compresses broadcasts, set if deflate.broadcastThreshold
   Gridmap                     m_gridmap;
+  Gridmap::Stats              m_gridmapStats;
+  PoolStats                   m_poolStats;
+  SyncStats                   m_syncStats;
+  SyncStats                   m_syncTimes;  // sums since the last updateStats
+  ObjectPool<Avatar>          m_avatarPool;
+  ObjectPool<Food>            m_foodPool;
+  ObjectPool<Bullet>          m_bulletPool;
+  ObjectPool<Virus>           m_virusPool;
+  ObjectPool<Phage>           m_phagePool;
+  ObjectPool<Mother>          m_motherPool;
   Sessions                    m_sessions;
   Players                     m_players;
   Fighters                    m_fighters;
@@ -165,17 +212,19 @@ private:
   RequestsMap                 m_ejectRequests;
   RequestsMap                 m_splitRequests;
   NextId                      m_cellNextId;
-  std::unordered_set<Cell*>   m_cells;
+  CellStore                   m_cells;
   std::unordered_set<Virus*>  m_viruses;
   std::unordered_set<Phage*>  m_phages;
   std::unordered_set<Mother*> m_mothers;
-  std::unordered_set<Cell*>   m_processingCells;
   std::unordered_set<Cell*>   m_forRandomPositionCheck;
-  std::unordered_set<Cell*>   m_newCells;
-  std::unordered_set<Cell*>   m_createdCells;
-  std::unordered_set<Cell*>   m_activatedCells;
-  std::unordered_set<Cell*>   m_modifiedCells;
+  CellRegistry                m_newCells {0};
+  CellRegistry                m_createdCells {1};
+  CellRegistry                m_activatedCells {2};
+  CellRegistry                m_modifiedCells {3};
+  FrameCache                  m_frameCache;
+  std::vector<Player*>        m_syncPlayers;
   std::vector<Cell*>          m_deadCells;
+  Gridmap::CellPairs          m_collisionPairs;
   std::list<ChatMessage>      m_chatHistory;
   PlayerWPtr                  m_topPlayer;
   int                         m_foodQuantity {0};
@@ -184,6 +233,7 @@ private:
   int                         m_mothersQuantity {0};
 
   TimePoint                   m_lastUpdate {TimePoint::clock::now()};
+  double                      m_time {0};   // seconds simulated by update()
   double                      m_mass {0};
   const uint32_t              m_id {0};
   bool                        m_updateLeaderboard {false};
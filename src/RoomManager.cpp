@@ -7,10 +7,11 @@
 
 #include <spdlog/spdlog.h>
 
-void RoomManager::start(const config::Room& config)
+void RoomManager::start(const config::Room& config, const config::Deflate& deflate)
 {
   std::lock_guard lock(m_mutex);
   m_config = config;
+  m_deflate = deflate;
   m_ioThreadPool.start(config.numThreads);
 }
 
@@ -33,8 +34,8 @@ Room* RoomManager::obtain()
     }
   }
 
-  auto room = std::make_unique<Room>(asio::make_strand(m_ioContext), m_nextId++);
-  room->init(m_config);
+  auto room = std::make_unique<Room>(asio::make_strand(m_ioContext), m_ioContext.get_executor(), m_nextId++);
+  room->init(m_config, m_deflate);
   room->start();
 
   if (m_items.empty()) {
@@ -50,4 +51,37 @@ size_t RoomManager::size() const
 {
   std::lock_guard lock(m_mutex);
   return m_items.size();
-}
\ No newline at end of file
+}
+
+RoomManager::GridmapStats RoomManager::getGridmapStats() const
+{
+  std::lock_guard lock(m_mutex);
+  GridmapStats result;
+  result.reserve(m_items.size());
+  for (const auto& room : m_items) {
+    result.emplace_back(room->getId(), room->getGridmapStats());
+  }
+  return result;
+}
+
+RoomManager::PoolStats RoomManager::getPoolStats() const
+{
+  std::lock_guard lock(m_mutex);
+  PoolStats result;
+  result.reserve(m_items.size());
+  for (const auto& room : m_items) {
+    result.emplace_back(room->getId(), room->getPoolStats());
+  }
+  return result;
+}
+
+RoomManager::SyncStats RoomManager::getSyncStats() const
+{
+  std::lock_guard lock(m_mutex);
+  SyncStats result;
+  result.reserve(m_items.size());
+  for (const auto& room : m_items) {
+    result.emplace_back(room->getId(), room->getSyncStats());
+  }
+  return result;
+}
@@ -13,15 +13,23 @@
 
 #include <memory>
 #include <mutex>
+#include <utility>
 #include <vector>
 
 class RoomManager {
 public:
-  void start(const config::Room& config);
+  using GridmapStats = std::vector<std::pair<uint32_t, Gridmap::Stats>>;
+  using PoolStats = std::vector<std::pair<uint32_t, Room::PoolStats>>;
+  using SyncStats = std::vector<std::pair<uint32_t, Room::SyncStats>>;
+
+  void start(const config::Room& config, const config::Deflate& deflate);
   void stop();
 
   Room* obtain();
   size_t size() const;
+  GridmapStats getGridmapStats() const;
+  PoolStats getPoolStats() const;
+  SyncStats getSyncStats() const;
 
 private:
   using Items = std::vector<std::unique_ptr<Room>>;
@@ -32,6 +40,7 @@ private:
   WorkGuard                   m_workGuard {m_ioContext.get_executor()};
   IOThreadPool                m_ioThreadPool {"Room worker", m_ioContext};
   config::Room                m_config;
+  config::Deflate             m_deflate;
   Items                       m_items;
   uint32_t                    m_nextId {1};
 };
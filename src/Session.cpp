@@ -3,10 +3,13 @@
 
 #include "Session.hpp"
 
+#include "Config.hpp"
+
 #include <spdlog/spdlog.h>
 
 #include <boost/asio/dispatch.hpp>
 
+#include <algorithm>
 #include <iostream>
 
 namespace asio = boost::asio;
@@ -83,6 +86,16 @@ void UserData::observable(PlayerPtr value)
   m_observable = std::move(value);
 }
 
+bool UserData::startGreeting()
+{
+  return !m_greeting.exchange(true);
+}
+
+void UserData::finishGreeting()
+{
+  m_greeting = false;
+}
+
 Session::Session(tcp::socket&& socket)
   : m_socket(std::move(socket))
   , m_remoteEndpoint([&]() -> tcp::endpoint{
@@ -100,6 +113,11 @@ tcp::endpoint Session::getRemoteEndpoint() const
   return m_remoteEndpoint;
 }
 
+asio::any_io_executor Session::getExecutor()
+{
+  return m_socket.get_executor();
+}
+
 void Session::setMessageHandler(MessageHandler&& handler)
 {
   m_messageHandler = std::move(handler);
@@ -115,6 +133,31 @@ void Session::setCloseHandler(CloseHandler&& handler)
   m_closeHandler = std::move(handler);
 }
 
+void Session::setDeflateOptions(const config::Deflate& options)
+{
+  m_deflate.server_enable = options.enabled;
+  m_deflate.compLevel = options.level;
+  m_deflate.memLevel = options.memLevel;
+  m_deflate.server_max_window_bits = options.windowBits;
+  m_deflate.server_no_context_takeover = options.noContextTakeover;
+}
+
+void Session::setSendLimits(const config::SendQueue& limits)
+{
+  m_maxQueuedBytes = limits.maxBytes;
+  m_maxQueuedMessages = limits.maxMessages;
+}
+
+SessionSendStats Session::getSendStats() const
+{
+  return {m_queuedBytes.load(std::memory_order_relaxed), m_droppedFrames.load(std::memory_order_relaxed)};
+}
+
+bool Session::takeResync()
+{
+  return m_resync.exchange(false);
+}
+
 void Session::run()
 {
   asio::dispatch(m_socket.get_executor(), std::bind_front(&Session::doRun, shared_from_this()));
@@ -130,9 +173,15 @@ void Session::send(const BufferPtr& buffer)
   asio::dispatch(m_socket.get_executor(), std::bind_front(&Session::doSend, shared_from_this(), buffer));
 }
 
+void Session::sendFrame(const BufferPtr& buffer, bool full)
+{
+  asio::dispatch(m_socket.get_executor(), std::bind_front(&Session::doSendFrame, shared_from_this(), buffer, full));
+}
+
 void Session::doRun()
 {
   m_socket.set_option(websocket::stream_base::timeout::suggested(beast::role_type::server));
+  m_socket.set_option(m_deflate);
   m_socket.set_option(websocket::stream_base::decorator(
     [](websocket::response_type& res)
     {
@@ -160,12 +209,60 @@ void Session::doSend(const BufferPtr& buffer)
   if (m_closed) {
     return;
   }
-  m_sendQueue.push(buffer);
+  push(buffer, false);
+}
+
+void Session::doSendFrame(const BufferPtr& buffer, bool full)
+{
+  if (m_closed) {
+    return;
+  }
+  if (m_resyncing && !full) {
+    // made before the player learned about the drop, it changes the state the client does not have
+    m_droppedFrames.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  auto bytes = m_queuedBytes.load(std::memory_order_relaxed) + buffer->size();
+  if ((m_maxQueuedBytes && bytes > m_maxQueuedBytes) ||
+      (m_maxQueuedMessages && m_sendQueue.size() >= m_maxQueuedMessages)) {
+    // The client is behind: the frames it has not been sent yet are stale. Drop them and this one, the player sends
+    // the full state instead. Reliable packets stay in the queue.
+    dropFrames();
+    m_droppedFrames.fetch_add(1, std::memory_order_relaxed);
+    if (!m_resyncing || full) { // a dropped full frame is asked for again
+      m_resyncing = true;
+      m_resync = true;
+    }
+    return;
+  }
+  m_resyncing = false;
+  push(buffer, true);
+}
+
+void Session::push(const BufferPtr& buffer, bool frame)
+{
+  m_sendQueue.push_back({buffer, frame});
+  m_queuedBytes.fetch_add(buffer->size(), std::memory_order_relaxed);
   if (m_sendQueue.size() == 1) {
     asio::dispatch(m_socket.get_executor(), std::bind_front(&Session::doWrite, shared_from_this()));
   }
 }
 
+void Session::dropFrames()
+{
+  // the batch being written stays
+  auto first = m_sendQueue.begin() + static_cast<std::ptrdiff_t>(std::min(m_writeBuffers.size(), m_sendQueue.size()));
+  auto last = std::remove_if(first, m_sendQueue.end(), [&](const Outgoing& outgoing) {
+    if (!outgoing.frame) {
+      return false;
+    }
+    m_queuedBytes.fetch_sub(outgoing.buffer->size(), std::memory_order_relaxed);
+    m_droppedFrames.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  });
+  m_sendQueue.erase(last, m_sendQueue.end());
+}
+
 void Session::doRead()
 {
   m_socket.async_read(
@@ -178,10 +275,14 @@ void Session::doWrite()
   if (m_closed) {
     return;
   }
-  const auto& data = m_sendQueue.front();
-  auto buffer = asio::buffer(data->data(), data->size());
+  // Everything queued since the last write goes out as one websocket message. Packets are self-delimiting and the
+  // client reads them one after another, as sessionMessageHandler does with incoming ones.
+  m_writeBuffers.clear();
+  for (const auto& [data, frame] : m_sendQueue) {
+    m_writeBuffers.emplace_back(data->data(), data->size());
+  }
   m_socket.async_write(
-    buffer, asio::bind_executor(m_socket.get_executor(), std::bind_front(&Session::onWrite, shared_from_this()))
+    m_writeBuffers, asio::bind_executor(m_socket.get_executor(), std::bind_front(&Session::onWrite, shared_from_this()))
   );
 }
 
@@ -207,9 +308,8 @@ void Session::onClose(beast::error_code ec)
     spdlog::error("close: {}", ec.message());
   }
 
-  while (!m_sendQueue.empty()) {
-    m_sendQueue.pop();
-  }
+  m_sendQueue.clear();
+  m_queuedBytes = 0;
 }
 
 void Session::onRead(beast::error_code ec, std::size_t bytesTransferred)
@@ -236,7 +336,12 @@ void Session::onWrite(beast::error_code ec, std::size_t bytesTransferred)
     spdlog::error("Failed to write: {}", ec.message());
   }
 
-  m_sendQueue.pop();
+  auto written = m_sendQueue.begin() + static_cast<std::ptrdiff_t>(std::min(m_writeBuffers.size(), m_sendQueue.size()));
+  for (auto it = m_sendQueue.begin(); it != written; ++it) {
+    m_queuedBytes.fetch_sub(it->buffer->size(), std::memory_order_relaxed);
+  }
+  m_sendQueue.erase(m_sendQueue.begin(), written);
+  m_writeBuffers.clear();
 
   if (!m_sendQueue.empty()) {
     asio::dispatch(m_socket.get_executor(), std::bind_front(&Session::doWrite, shared_from_this()));
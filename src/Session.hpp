@@ -14,7 +14,9 @@
 #include <boost/beast/core.hpp>
 #include <boost/beast/websocket.hpp>
 
-#include <queue>
+#include <atomic>
+#include <deque>
+#include <vector>
 
 namespace asio = boost::asio;
 namespace beast = boost::beast;
@@ -24,6 +26,16 @@ using tcp = boost::asio::ip::tcp;
 
 class Room;
 
+namespace config {
+  struct Deflate;
+  struct SendQueue;
+}
+
+struct SessionSendStats {
+  size_t    queuedBytes {0};            // waiting to be written or being written
+  uint64_t  droppedFrames {0};          // since the session was opened
+};
+
 class UserData {
 public:
   SystemTimePoint created() const;
@@ -41,6 +53,10 @@ public:
   void player(PlayerPtr value);
   void observable(PlayerPtr value);
 
+  // One greeting at a time: false while another one is being looked up.
+  bool startGreeting();
+  void finishGreeting();
+
 private:
   mutable std::mutex    m_mutex;
   const SystemTimePoint m_created {SystemTimePoint::clock::now()};  // thread-safe, const
@@ -50,6 +66,7 @@ private:
   uint32_t              m_playerId {0};                             // thread-safe, accessed only from Room
   PlayerPtr             m_player;                                   // thread-safe, accessed only from Room
   PlayerPtr             m_observable;                               // thread-safe, accessed only from Room
+  std::atomic<bool>     m_greeting {false};
 };
 
 class Session : public std::enable_shared_from_this<Session>, public UserData
@@ -62,19 +79,33 @@ public:
   explicit Session(tcp::socket&& socket);
 
   tcp::endpoint getRemoteEndpoint() const;
+  asio::any_io_executor getExecutor();
 
   void setMessageHandler(MessageHandler&& handler);
   void setOpenHandler(OpenHandler&& handler);
   void setCloseHandler(CloseHandler&& handler);
+  // Applied when the websocket handshake is accepted.
+  void setDeflateOptions(const config::Deflate& options);
+  void setSendLimits(const config::SendQueue& limits);
+
+  [[nodiscard]] SessionSendStats getSendStats() const;
+  // True once after the session has dropped frames; the next frame sent to it should be a full one.
+  [[nodiscard]] bool takeResync();
 
   void run();
   void close();
   void send(const BufferPtr& buffer);
+  // Frames supersede one another. When the send queue is over its limits the queued frames are dropped, and so is
+  // every frame after them until a full one arrives.
+  void sendFrame(const BufferPtr& buffer, bool full);
 
 private:
   void doRun();
   void doClose();
   void doSend(const BufferPtr& buffer);
+  void doSendFrame(const BufferPtr& buffer, bool full);
+  void push(const BufferPtr& buffer, bool frame);
+  void dropFrames();
   void doRead();
   void doWrite();
 
@@ -84,7 +115,12 @@ private:
   void onWrite(beast::error_code ec, std::size_t bytesTransferred);
 
 private:
-  using SendQueue = std::queue<BufferPtr>;
+  struct Outgoing {
+    BufferPtr buffer;
+    bool      frame;
+  };
+
+  using SendQueue = std::deque<Outgoing>;
 
   websocket::stream<beast::tcp_stream>  m_socket;
   const tcp::endpoint                   m_remoteEndpoint;
@@ -92,7 +128,15 @@ private:
   OpenHandler                           m_openHandler;
   CloseHandler                          m_closeHandler;
   beast::flat_buffer                    m_buffer {};
+  websocket::permessage_deflate         m_deflate {};
   SendQueue                             m_sendQueue {};
+  std::vector<asio::const_buffer>       m_writeBuffers {};  // the front of m_sendQueue being written
+  size_t                                m_maxQueuedBytes {0};
+  size_t                                m_maxQueuedMessages {0};
+  std::atomic<size_t>                   m_queuedBytes {0};
+  std::atomic<uint64_t>                 m_droppedFrames {0};
+  std::atomic<bool>                     m_resync {false};     // the player is yet to notice the dropped frames
+  bool                                  m_resyncing {false};  // dropping frames until a full one
   bool                                  m_closed {false};
 };
 
@@ -0,0 +1,114 @@
+// file   : src/SessionLogger.cpp
+// author : sba <bohdan.sadovyak@gmail.com>
+
+#include "SessionLogger.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+
+SessionLogger::SessionLogger(Writer writer)
+  : m_writer(std::move(writer))
+{
+}
+
+SessionLogger::~SessionLogger()
+{
+  stop();
+}
+
+void SessionLogger::start(const config::SessionLog& config)
+{
+  std::lock_guard lock(m_mutex);
+  if (m_running) {
+    return;
+  }
+  m_config = config;
+  m_running = true;
+  m_thread = std::thread(&SessionLogger::run, this);
+}
+
+void SessionLogger::stop()
+{
+  {
+    std::lock_guard lock(m_mutex);
+    m_running = false;
+  }
+  m_condition.notify_one();
+  if (m_thread.joinable()) {
+    m_thread.join();
+  }
+}
+
+void SessionLogger::log(const SessionRecord& record)
+{
+  std::unique_lock lock(m_mutex);
+  if (m_config.queueSize && m_queue.size() >= m_config.queueSize) {
+    ++m_stats.dropped;
+    return;
+  }
+  m_queue.emplace_back(record);
+  if (m_queue.size() == m_config.batchSize) {
+    lock.unlock();
+    m_condition.notify_one();
+  }
+}
+
+SessionLoggerStats SessionLogger::getStats() const
+{
+  std::lock_guard lock(m_mutex);
+  auto stats = m_stats;
+  stats.queued = m_queue.size();
+  return stats;
+}
+
+void SessionLogger::run()
+{
+  spdlog::info("Start \"Session logger\"");
+  std::vector<SessionRecord> records;
+  std::unique_lock lock(m_mutex);
+  while (true) {
+    m_condition.wait_for(lock, m_config.flushInterval, [&] {
+      return !m_running || m_queue.size() >= m_config.batchSize;
+    });
+    if (!m_queue.empty()) {
+      // the two vectors take turns, so once they have grown the queue does not allocate
+      records.swap(m_queue);
+      lock.unlock();
+      write(records);
+      records.clear();
+      lock.lock();
+    }
+    if (!m_running && m_queue.empty()) {
+      break;
+    }
+  }
+  spdlog::info("Stop \"Session logger\"");
+}
+
+void SessionLogger::write(const std::vector<SessionRecord>& records)
+{
+  const auto startTime = TimePoint::clock::now();
+  uint64_t written = 0;
+  uint64_t dropped = 0;
+  for (size_t offset = 0; offset < records.size(); ) {
+    auto count = std::min<size_t>(m_config.batchSize, records.size() - offset);
+    std::span<const SessionRecord> batch(records.data() + offset, count);
+    offset += count;
+    try {
+      m_writer(batch);
+      written += count;
+    } catch (const std::exception& e) {
+      spdlog::warn("An exception occurred while saving sessions: {}", e.what());
+      dropped += count;
+    }
+  }
+  auto duration = std::chrono::duration_cast<std::chrono::microseconds>(TimePoint::clock::now() - startTime);
+
+  std::lock_guard lock(m_mutex);
+  m_stats.written += written;
+  m_stats.dropped += dropped;
+  ++m_stats.flushes;
+  m_stats.lastFlush = duration;
+  m_stats.maxFlush = std::max(m_stats.maxFlush, duration);
+}
@@ -0,0 +1,68 @@
+// file   : src/SessionLogger.hpp
+// author : sba <bohdan.sadovyak@gmail.com>
+
+#ifndef THEGAME_SESSION_LOGGER_HPP
+#define THEGAME_SESSION_LOGGER_HPP
+
+#include "Config.hpp"
+#include "TimePoint.hpp"
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+struct SessionRecord {
+  SystemTimePoint begin;
+  SystemTimePoint end;
+  uint32_t        userId {0};
+  uint32_t        ip {0};
+};
+
+struct SessionLoggerStats {
+  size_t                    queued {0};       // records waiting to be written
+  uint64_t                  written {0};
+  uint64_t                  dropped {0};      // the queue was full or the write failed
+  uint64_t                  flushes {0};
+  std::chrono::microseconds lastFlush {0};
+  std::chrono::microseconds maxFlush {0};
+};
+
+// Writes the records of closed sessions from a thread of its own, in batches: every flushInterval, or as soon as
+// batchSize records are waiting. log() only appends to the queue under a short lock, so the IO threads never wait for
+// the database. Records coming while queueSize of them are waiting are dropped.
+class SessionLogger {
+public:
+  // Writes one batch, at most batchSize records. Called from the logger's thread.
+  using Writer = std::function<void(std::span<const SessionRecord> records)>;
+
+  explicit SessionLogger(Writer writer);
+  SessionLogger(const SessionLogger&) = delete;
+  SessionLogger& operator=(const SessionLogger&) = delete;
+  ~SessionLogger();
+
+  void start(const config::SessionLog& config);
+  // Writes everything queued, then joins the thread.
+  void stop();
+
+  void log(const SessionRecord& record);
+
+  [[nodiscard]] SessionLoggerStats getStats() const;
+
+private:
+  void run();
+  void write(const std::vector<SessionRecord>& records);
+
+  const Writer                m_writer;
+  config::SessionLog          m_config;
+  mutable std::mutex          m_mutex;
+  std::condition_variable     m_condition;
+  std::vector<SessionRecord>  m_queue;        // guarded by m_mutex
+  SessionLoggerStats          m_stats;        // guarded by m_mutex
+  bool                        m_running {false};
+  std::thread                 m_thread;
+};
+
+#endif /* THEGAME_SESSION_LOGGER_HPP */
@@ -26,6 +26,32 @@ void User::setToken(const std::string& v)
   m_modified = true;
 }
 
+uint32_t User::getIp() const
+{
+  std::lock_guard lock(m_mutex);
+  return m_ip;
+}
+
+void User::setIp(uint32_t v)
+{
+  std::lock_guard lock(m_mutex);
+  m_ip = v;
+  m_modified = true;
+}
+
+std::optional<SystemTimePoint> User::getCreated() const
+{
+  std::lock_guard lock(m_mutex);
+  return m_created;
+}
+
+void User::setCreated(const SystemTimePoint& v)
+{
+  std::lock_guard lock(m_mutex);
+  m_created = v;
+  m_modified = true;
+}
+
 TimePoint User::getLastAccess() const
 {
   std::lock_guard lock(m_mutex);
@@ -38,6 +64,12 @@ bool User::isModified() const
   return m_modified;
 }
 
+void User::setModified(bool v)
+{
+  std::lock_guard lock(m_mutex);
+  m_modified = v;
+}
+
 void User::setLastAccess(const TimePoint& v)
 {
   std::lock_guard lock(m_mutex);
@@ -55,3 +87,11 @@ void User::setSession(const SessionPtr& sess)
   std::lock_guard lock(m_mutex);
   m_session = sess;
 }
+
+void User::releaseSession(const SessionPtr& sess)
+{
+  std::lock_guard lock(m_mutex);
+  if (m_session == sess) {
+    m_session.reset();
+  }
+}
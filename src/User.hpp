@@ -10,6 +10,7 @@
 
 #include <string>
 #include <mutex>
+#include <optional>
 
 class User {
 public:
@@ -17,11 +18,15 @@ public:
 
   uint32_t getId() const;
   std::string getToken() const;
+  uint32_t getIp() const;
+  std::optional<SystemTimePoint> getCreated() const;
   TimePoint getLastAccess() const;
   bool isModified() const;
 
   SessionPtr getSession() const;
   void setSession(const SessionPtr& sess);
+  // Forgets the session if it is still `sess`.
+  void releaseSession(const SessionPtr& sess);
 
   struct Touch {
     void operator ()(const UserPtr& obj) const
@@ -32,6 +37,9 @@ public:
 
 private:
   void setToken(const std::string& v);
+  void setIp(uint32_t v);
+  void setCreated(const SystemTimePoint& v);
+  void setModified(bool v);
   void setLastAccess(const TimePoint& v);
 
   mutable std::mutex  m_mutex;
@@ -39,7 +47,9 @@ private:
   std::string         m_token;
   std::string         m_name;
   TimePoint           m_lastAccess {TimePoint::clock::now()};
+  std::optional<SystemTimePoint> m_created; // known only for the users handed out from the token pool
   const uint32_t      m_id {0};
+  uint32_t            m_ip {0};
   bool                m_modified {true};
 
   friend class UsersCache;
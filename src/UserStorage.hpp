@@ -0,0 +1,41 @@
+// file   : src/UserStorage.hpp
+// author : sba <bohdan.sadovyak@gmail.com>
+
+#ifndef THEGAME_USER_STORAGE_HPP
+#define THEGAME_USER_STORAGE_HPP
+
+#include "TimePoint.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+struct UserRecord {
+  uint32_t    id {0};
+  std::string token;
+  uint32_t    ip {0};
+  std::optional<SystemTimePoint> created; // written by update() when set
+};
+
+// Where UsersCache loads the users from and saves them to. It is called from the DB workers without any lock held, so
+// implementations must be thread safe, and independent calls should not wait for each other.
+class UserStorage {
+public:
+  virtual ~UserStorage() = default;
+
+  virtual std::optional<UserRecord> findById(uint32_t id) = 0;
+  virtual std::optional<UserRecord> findByToken(const std::string& token) = 0;
+  // The id of the new user, 0 if it was not inserted.
+  virtual uint32_t insert(const std::string& token, uint32_t ip, SystemTimePoint created) = 0;
+  // Registers users ahead of time, with no ip yet and `created` standing for the time they are handed out, which
+  // update() writes later. Returns the ones inserted, in any order.
+  virtual std::vector<UserRecord> insert(std::span<const std::string> tokens, SystemTimePoint created) = 0;
+  // Writes the token, ip and, if set, creation time of each user in one statement.
+  virtual void update(std::span<const UserRecord> records) = 0;
+  // Deletes users registered ahead of time that were never handed out.
+  virtual void remove(std::span<const uint32_t> ids) = 0;
+};
+
+#endif /* THEGAME_USER_STORAGE_HPP */
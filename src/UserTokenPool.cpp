@@ -0,0 +1,120 @@
+// file   : src/UserTokenPool.cpp
+// author : sba <bohdan.sadovyak@gmail.com>
+
+#include "UserTokenPool.hpp"
+
+#include "util.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <boost/asio/post.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <string>
+
+UserTokenPool::UserTokenPool(const asio::any_io_executor& executor, UserStorage& storage)
+  : m_executor(executor)
+  , m_storage(storage)
+{
+}
+
+void UserTokenPool::start(const config::TokenPool& config)
+{
+  {
+    std::lock_guard lock(m_mutex);
+    m_config = config;
+    m_records.reserve(config.capacity);
+  }
+  scheduleRefill();
+}
+
+void UserTokenPool::stop()
+{
+  std::vector<uint32_t> ids;
+  {
+    std::lock_guard lock(m_mutex);
+    m_config.capacity = 0;
+    for (const auto& record : m_records) {
+      ids.push_back(record.id);
+    }
+    m_records.clear();
+  }
+  if (ids.empty()) {
+    return;
+  }
+  try {
+    m_storage.remove(ids);
+    spdlog::info("Removed {} users registered ahead and not handed out", ids.size());
+  } catch (const std::exception& e) {
+    spdlog::warn("An exception occurred while removing unused users: {}", e.what());
+  }
+}
+
+std::optional<UserRecord> UserTokenPool::pop()
+{
+  std::optional<UserRecord> result;
+  bool low;
+  {
+    std::lock_guard lock(m_mutex);
+    if (m_records.empty()) {
+      ++m_stats.empty;
+    } else {
+      result = std::move(m_records.back());
+      m_records.pop_back();
+      ++m_stats.popped;
+    }
+    low = m_records.size() <= m_config.lowWater;
+  }
+  if (low) {
+    scheduleRefill();
+  }
+  return result;
+}
+
+UserTokenPoolStats UserTokenPool::getStats() const
+{
+  std::lock_guard lock(m_mutex);
+  auto stats = m_stats;
+  stats.size = m_records.size();
+  return stats;
+}
+
+void UserTokenPool::scheduleRefill()
+{
+  if (!m_config.capacity || m_refilling.exchange(true)) {
+    return;
+  }
+  asio::post(m_executor, [this] { refill(); });
+}
+
+void UserTokenPool::refill()
+{
+  std::vector<std::string> tokens;
+  try {
+    while (true) {
+      size_t count;
+      {
+        std::lock_guard lock(m_mutex);
+        if (m_records.size() >= m_config.capacity) {
+          break;
+        }
+        count = std::min<size_t>(m_config.batchSize, m_config.capacity - m_records.size());
+      }
+      tokens.clear();
+      for (size_t i = 0; i < count; ++i) {
+        tokens.emplace_back(randomString(32));
+      }
+      auto records = m_storage.insert(tokens, SystemTimePoint::clock::now());
+      std::lock_guard lock(m_mutex);
+      m_stats.inserted += records.size();
+      std::move(records.begin(), records.end(), std::back_inserter(m_records));
+      if (records.empty()) {
+        break;
+      }
+    }
+  } catch (const std::exception& e) {
+    spdlog::warn("An exception occurred while registering users ahead: {}", e.what());
+  }
+  m_refilling = false;
+}
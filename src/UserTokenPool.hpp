@@ -0,0 +1,56 @@
+// file   : src/UserTokenPool.hpp
+// author : sba <bohdan.sadovyak@gmail.com>
+
+#ifndef THEGAME_USER_TOKEN_POOL_HPP
+#define THEGAME_USER_TOKEN_POOL_HPP
+
+#include "Config.hpp"
+#include "UserStorage.hpp"
+
+#include <boost/asio/any_io_executor.hpp>
+
+#include <atomic>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace asio = boost::asio;
+
+struct UserTokenPoolStats {
+  size_t    size {0};                   // users ready to be handed out
+  uint64_t  popped {0};
+  uint64_t  empty {0};                  // pops that found the pool empty
+  uint64_t  inserted {0};
+};
+
+// Users registered ahead of time, so that a registration is a pop instead of an INSERT. When the pool runs down to
+// lowWater, a refill on the executor inserts new users in batches until there are `capacity` of them again. The time
+// and ip of a registration are written when its user is saved.
+class UserTokenPool {
+public:
+  UserTokenPool(const asio::any_io_executor& executor, UserStorage& storage);
+
+  // Sets the limits and fills the pool.
+  void start(const config::TokenPool& config);
+  // Stops refilling and deletes the users still in the pool, whose tokens nobody has. Called once no refill runs.
+  void stop();
+
+  // None when the pool is empty.
+  std::optional<UserRecord> pop();
+
+  [[nodiscard]] UserTokenPoolStats getStats() const;
+
+private:
+  void scheduleRefill();
+  void refill();
+
+  asio::any_io_executor   m_executor;
+  UserStorage&            m_storage;
+  config::TokenPool       m_config {.capacity = 0};   // nothing is registered before start()
+  mutable std::mutex      m_mutex;
+  std::vector<UserRecord> m_records;      // guarded by m_mutex
+  UserTokenPoolStats      m_stats;        // guarded by m_mutex
+  std::atomic<bool>       m_refilling {false};
+};
+
+#endif /* THEGAME_USER_TOKEN_POOL_HPP */
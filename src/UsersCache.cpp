@@ -3,128 +3,199 @@
 
 #include "UsersCache.hpp"
 
-#include "ScopeExit.hpp"
 #include "util.hpp"
 
-#include <fmt/chrono.h>
-#include <mysql++/ssqls.h>
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <vector>
 
-sql_create_3(DboUserCreate, 1, 0,
-  mysqlpp::sql_varchar, token,
-  mysqlpp::sql_datetime, created,
-  mysqlpp::sql_int_unsigned, ip
-)
-
-sql_create_2(DboUser, 1, 0,
-  mysqlpp::sql_int_unsigned, id,
-  mysqlpp::sql_varchar, token
-)
-
-UsersCache::UsersCache(MySQLConnectionPool& pool)
-  : m_mysqlConnectionPool(pool)
+UsersCache::UsersCache(UserStorage& storage, UserTokenPool* tokenPool)
+  : m_storage(storage)
+  , m_tokenPool(tokenPool)
 {
-  DboUserCreate::table("users");
-  DboUser::table("users");
 }
 
-void UsersCache::save()
+size_t UsersCache::save(size_t batchSize)
 {
-  std::lock_guard lock(m_mutex);
-  if (m_items.empty()) {
-    return;
+  std::lock_guard saveLock(m_saveMutex);
+  std::vector<UserPtr> users;
+  for (auto& shard : m_shards) {
+    std::lock_guard lock(shard.mutex);
+    users.insert(users.end(), shard.modified.begin(), shard.modified.end());
+    shard.modified.clear();
+  }
+  for (const auto& user : users) {
+    user->setModified(false);
   }
-  mysqlpp::Connection::thread_start();
-  ScopeExit onExit([](){ mysqlpp::Connection::thread_end(); });
-  mysqlpp::ScopedConnection db(m_mysqlConnectionPool, true);
-  auto query = db->query();
-  DboUser dbo;
-  for (const UserPtr& item : m_items) {
-    DboUser orig;
-    orig.id = item->getId();
-    dbo.id = orig.id;
-    dbo.token = item->getToken();
-    query.update(orig, dbo);
-    query.execute();
+
+  std::vector<UserRecord> records;
+  size_t saved = 0;
+  try {
+    while (saved < users.size()) {
+      auto count = std::min(batchSize, users.size() - saved);
+      records.clear();
+      for (size_t i = saved; i < saved + count; ++i) {
+        records.push_back({users[i]->getId(), users[i]->getToken(), users[i]->getIp(), users[i]->getCreated()});
+      }
+      m_storage.update(records);
+      saved += count;
+    }
+  } catch (...) {
+    // the rest is saved next time
+    for (size_t i = saved; i < users.size(); ++i) {
+      setModified(users[i]);
+    }
+    m_saved += saved;
+    throw;
   }
+  m_saved += saved;
+  return saved;
+}
+
+size_t UsersCache::evict(Duration ttl)
+{
+  const auto threshold = TimePoint::clock::now() - ttl;
+  size_t count = 0;
+  for (auto& shard : m_shards) {
+    std::lock_guard lock(shard.mutex);
+    auto& ind = shard.items.get<ByLastAccess>();
+    for (auto it = ind.begin(); it != ind.end() && (*it)->getLastAccess() < threshold; ) {
+      if ((*it)->getSession() || (*it)->isModified()) {
+        ++it; // still connected, or not saved yet
+      } else {
+        it = ind.erase(it);
+        ++count;
+      }
+    }
+  }
+  m_evictions += count;
+  return count;
 }
 
 UserPtr UsersCache::create(uint32_t ip)
 {
-  std::lock_guard lock(m_mutex);
-  auto& ind = m_items.get<ByToken>();
-  DboUserCreate dbo;
-  dbo.created = mysqlpp::String(fmt::to_string(std::chrono::system_clock::now()));
-  uint32_t id = 0;
-  mysqlpp::Connection::thread_start();
-  ScopeExit onExit([] { mysqlpp::Connection::thread_end(); });
-  mysqlpp::ScopedConnection db(m_mysqlConnectionPool, true);
-  do {
-    dbo.token = randomString(32);
-    if (ind.find(dbo.token) != ind.end()) {
-      continue;
+  if (m_tokenPool) {
+    if (auto record = m_tokenPool->pop()) {
+      const auto& user = std::make_shared<User>(record->id);
+      user->setToken(record->token);
+      // the row was inserted when the pool was refilled, without an ip: both are written by save()
+      user->setIp(ip);
+      user->setCreated(SystemTimePoint::clock::now());
+      auto& shard = getShard(record->token);
+      std::lock_guard lock(shard.mutex);
+      if (!shard.items.emplace(user).second) {
+        throw std::runtime_error("Bad insert new user into the users cache");
+      }
+      shard.modified.push_back(user);
+      return user;
+    }
+  }
+  const auto created = SystemTimePoint::clock::now();
+  while (true) {
+    auto token = randomString(32);
+    auto& shard = getShard(token);
+    {
+      std::lock_guard lock(shard.mutex);
+      const auto& ind = shard.items.get<ByToken>();
+      if (ind.find(token) != ind.end()) {
+        continue;
+      }
     }
-    dbo.ip = ip;
-    auto query = db->query();
-    query.insert(dbo);
-    if (query.execute().rows()) {
-      id = query.insert_id();
+    if (auto id = m_storage.insert(token, ip, created)) {
+      const auto& user = std::make_shared<User>(id);
+      user->setToken(token);
+      user->setIp(ip);
+      user->setModified(false);
+      std::lock_guard lock(shard.mutex);
+      if (!shard.items.emplace(user).second) {
+        throw std::runtime_error("Bad insert new user into the users cache");
+      }
+      return user;
     }
-  } while (!id);
-  const auto& user = std::make_shared<User>(id);
-  user->setToken(dbo.token);
-  if (!m_items.emplace(user).second) {
-    throw std::runtime_error("Bad insert new user into the users cache");
   }
-  return user;
 }
 
 UserPtr UsersCache::getUserById(uint32_t id)
 {
-  std::lock_guard lock(m_mutex);
-  const auto& it = m_items.find(id);
-  if (it != m_items.end()) {
-    m_items.modify(it, User::Touch());
-    return *it;
-  }
-  mysqlpp::Connection::thread_start();
-  ScopeExit onExit([] { mysqlpp::Connection::thread_end(); });
-  mysqlpp::ScopedConnection db(m_mysqlConnectionPool, true);
-  auto query = db->query();
-  query << "SELECT id,token FROM users WHERE id=" << mysqlpp::quote_only << id;
-  auto res = query.store();
-  if (!res.empty()) {
-    const DboUser& dbo = res[0];
-    const auto& user = std::make_shared<User>(dbo.id);
-    user->setToken(dbo.token);
-    if (!m_items.emplace(user).second) {
-      throw std::runtime_error("Bad insert user into the users cache by id");
+  for (auto& shard : m_shards) {
+    std::lock_guard lock(shard.mutex);
+    const auto& it = shard.items.find(id);
+    if (it != shard.items.end()) {
+      shard.items.modify(it, User::Touch());
+      ++m_hits;
+      return *it;
     }
-    return user;
+  }
+  ++m_misses;
+  if (auto record = m_storage.findById(id)) {
+    return emplace(*record);
   }
   return {};
 }
 
 UserPtr UsersCache::getUserByToken(const std::string& sid)
 {
-  std::lock_guard lock(m_mutex);
-  auto& ind = m_items.get<ByToken>();
-  if (const auto& it = ind.find(sid); it != ind.end()) {
-    ind.modify(it, User::Touch());
-    return *it;
-  }
-  mysqlpp::Connection::thread_start();
-  ScopeExit onExit([] { mysqlpp::Connection::thread_end(); });
-  mysqlpp::ScopedConnection db(m_mysqlConnectionPool, true);
-  auto query = db->query();
-  query << "SELECT id,token FROM users WHERE token=" << mysqlpp::quote_only << sid;
-  if (auto res = query.store(); !res.empty()) {
-    const DboUser& dbo = res[0];
-    const auto& user = std::make_shared<User>(dbo.id);
-    user->setToken(dbo.token);
-    if (!m_items.emplace(user).second) {
-      throw std::runtime_error("Bad insert user into the users cache by token");
+  {
+    auto& shard = getShard(sid);
+    std::lock_guard lock(shard.mutex);
+    auto& ind = shard.items.get<ByToken>();
+    if (const auto& it = ind.find(sid); it != ind.end()) {
+      ind.modify(it, User::Touch());
+      ++m_hits;
+      return *it;
     }
-    return user;
+  }
+  ++m_misses;
+  if (auto record = m_storage.findByToken(sid)) {
+    return emplace(*record);
   }
   return {};
 }
+
+UsersCacheStats UsersCache::getStats() const
+{
+  UsersCacheStats stats;
+  for (const auto& shard : m_shards) {
+    std::lock_guard lock(shard.mutex);
+    stats.size += shard.items.size();
+    stats.modified += shard.modified.size();
+  }
+  stats.hits = m_hits;
+  stats.misses = m_misses;
+  stats.evictions = m_evictions;
+  stats.saved = m_saved;
+  return stats;
+}
+
+UsersCache::Shard& UsersCache::getShard(const std::string& token)
+{
+  return m_shards[std::hash<std::string>{}(token) % ShardCount];
+}
+
+void UsersCache::setModified(const UserPtr& user)
+{
+  user->setModified(true);
+  auto& shard = getShard(user->getToken());
+  std::lock_guard lock(shard.mutex);
+  shard.modified.push_back(user);
+}
+
+UserPtr UsersCache::emplace(const UserRecord& record)
+{
+  const auto& user = std::make_shared<User>(record.id);
+  user->setToken(record.token);
+  user->setIp(record.ip);
+  user->setModified(false);
+  auto& shard = getShard(record.token);
+  std::lock_guard lock(shard.mutex);
+  // a concurrent lookup of the same user may have been first
+  if (const auto& it = shard.items.find(record.id); it != shard.items.end()) {
+    shard.items.modify(it, User::Touch());
+    return *it;
+  }
+  if (!shard.items.emplace(user).second) {
+    throw std::runtime_error("Bad insert user into the users cache");
+  }
+  return user;
+}
@@ -4,8 +4,9 @@
 #ifndef THEGAME_USERS_CACHE_HPP
 #define THEGAME_USERS_CACHE_HPP
 
-#include "MySQLConnectionPool.hpp"
 #include "User.hpp"
+#include "UserStorage.hpp"
+#include "UserTokenPool.hpp"
 
 #if !defined(NDEBUG)
   #define BOOST_MULTI_INDEX_ENABLE_INVARIANT_CHECKING
@@ -15,19 +16,45 @@
 #include <boost/multi_index/ordered_index.hpp>
 #include <boost/multi_index/mem_fun.hpp>
 
-#include <string>
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <mutex>
+#include <string>
+#include <vector>
+
+struct UsersCacheStats {
+  size_t    size {0};                   // cached users
+  uint64_t  hits {0};
+  uint64_t  misses {0};                 // lookups that went to the storage
+  uint64_t  evictions {0};
+  size_t    modified {0};               // users waiting to be saved
+  uint64_t  saved {0};
+};
 
+// The users seen recently, in front of their storage. The users are sharded by token hash into independently locked
+// partitions, and a lock only guards its shard's items: storage calls are made without it, so lookups of different
+// users run in parallel on the DB workers. evict() drops the users idle for longer than a TTL, save() writes the
+// modified ones.
 class UsersCache {
 public:
-  explicit UsersCache(MySQLConnectionPool& pool);
+  static constexpr size_t ShardCount {16};
 
-  void save();
+  // New users are taken from the token pool while it has some.
+  explicit UsersCache(UserStorage& storage, UserTokenPool* tokenPool = nullptr);
+
+  // Writes the modified users in batches of `batchSize`, returns how many. The shards are locked only to take their
+  // modified users, the storage is written without any of their locks.
+  size_t save(size_t batchSize);
+  // Drops the users not looked up for `ttl` that have no session and are saved, returns how many.
+  size_t evict(Duration ttl);
 
   UserPtr create(uint32_t ip);
   UserPtr getUserById(uint32_t id);
   UserPtr getUserByToken(const std::string& sid);
 
+  [[nodiscard]] UsersCacheStats getStats() const;
+
 protected:
   struct ById { };
   struct ByToken { };
@@ -51,9 +78,26 @@ protected:
     >
   >;
 
-  MySQLConnectionPool&          m_mysqlConnectionPool;
-  mutable std::mutex            m_mutex;
-  Items                         m_items;
+  struct alignas(64) Shard {            // a cache line each, so the locks do not share one
+    mutable std::mutex    mutex;
+    Items                 items;
+    std::vector<UserPtr>  modified;       // to be saved
+  };
+
+  Shard& getShard(const std::string& token);
+  // Queues the user for the next save.
+  void setModified(const UserPtr& user);
+  // The cached user with the record's id, added if there is none yet.
+  UserPtr emplace(const UserRecord& record);
+
+  UserStorage&                    m_storage;
+  UserTokenPool*                  m_tokenPool {nullptr};
+  std::array<Shard, ShardCount>   m_shards;
+  std::mutex                      m_saveMutex;    // one save at a time
+  std::atomic<uint64_t>           m_hits {0};
+  std::atomic<uint64_t>           m_misses {0};
+  std::atomic<uint64_t>           m_evictions {0};
+  std::atomic<uint64_t>           m_saved {0};
 };
 
 #endif /* THEGAME_USERS_CACHE_HPP */
@@ -34,20 +34,26 @@ void Avatar::setMass(float value)
 void Avatar::format(Buffer& buffer)
 {
   auto moving = static_cast<bool>(velocity);
-  serialize(buffer, static_cast<uint8_t>(type | isNew * newly | isMoving * moving));
-  serialize(buffer, id);
-  serialize(buffer, position.x);
-  serialize(buffer, position.y);
-  serialize(buffer, static_cast<uint32_t>(mass));
-  serialize(buffer, static_cast<uint16_t>(radius));
-  serialize(buffer, color);
-  serialize(buffer, player->getId());
+  BufferWriter writer(buffer, 32);
+  writer.write(static_cast<uint8_t>(type | isNew * newly | isMoving * moving));
+  writer.write(id);
+  writer.write(position.x);
+  writer.write(position.y);
+  writer.write(static_cast<uint32_t>(mass));
+  writer.write(static_cast<uint16_t>(radius));
+  writer.write(color);
+  writer.write(player->getId());
   if (moving) {
-    serialize(buffer, velocity.x);
-    serialize(buffer, velocity.y);
+    writer.write(velocity.x);
+    writer.write(velocity.y);
   }
 }
 
+float Avatar::getFoodReach() const
+{
+  return radius + static_cast<float>(m_config.food.radius);
+}
+
 void Avatar::interact(Cell& cell)
 {
   cell.interact(*this);
@@ -16,6 +16,8 @@ public:
 
   void format(Buffer& buffer) override;
 
+  float getFoodReach() const override;
+
   void interact(Cell& cell) override;
   void interact(Avatar& avatar) override;
   void interact(Food& food) override;
@@ -17,10 +17,10 @@ Cell::Cell(
   : id(id)
   , m_config(config)
   , m_entityFactory(entityFactory)
-  , m_deathEmitter(entityFactory.getDeathExecutor())
-  , m_massChangedEmitter(entityFactory.getGameExecutor())
-  , m_motionStartedEmitter(entityFactory.getGameExecutor())
-  , m_motionStoppedEmitter(entityFactory.getGameExecutor())
+  , m_deathEmitter(entityFactory.getDeathEvents())
+  , m_massChangedEmitter(entityFactory.getGameEvents())
+  , m_motionStartedEmitter(entityFactory.getGameEvents())
+  , m_motionStoppedEmitter(entityFactory.getGameEvents())
 {
   resistanceRatio = config.resistanceRatio;
 }
@@ -52,9 +52,9 @@ void Cell::modifyVelocity(const Vec2D& value)
   m_motionStartedEmitter.emit();
 }
 
-void Cell::applyResistanceForce()
+float Cell::getFoodReach() const
 {
-  force -= velocity.direction() * (radius * resistanceRatio);
+  return 0;
 }
 
 bool Cell::intersects(const AABB& box)
@@ -62,33 +62,20 @@ bool Cell::intersects(const AABB& box)
   return geometry::intersects(box, *this);
 }
 
-void Cell::simulate(double dt)
-{
-  auto acceleration = force / mass;
-  auto prevVelocity = velocity;
-  velocity += acceleration * dt;
-  if (std::fabs(1 + velocity.direction() * prevVelocity.direction()) <= 0.01) {
-    velocity.zero();
-    m_motionStoppedEmitter.emit();
-  } else {
-    position += velocity * dt;
-  }
-  force.zero();
-}
-
 void Cell::format(Buffer& buffer)
 {
   auto moving = static_cast<bool>(velocity);
-  serialize(buffer, static_cast<uint8_t>(type | isNew * newly | isMoving * moving));
-  serialize(buffer, id);
-  serialize(buffer, position.x);
-  serialize(buffer, position.y);
-  serialize(buffer, static_cast<uint32_t>(mass));
-  serialize(buffer, static_cast<uint16_t>(radius));
-  serialize(buffer, color);
+  BufferWriter writer(buffer, 28);
+  writer.write(static_cast<uint8_t>(type | isNew * newly | isMoving * moving));
+  writer.write(id);
+  writer.write(position.x);
+  writer.write(position.y);
+  writer.write(static_cast<uint32_t>(mass));
+  writer.write(static_cast<uint16_t>(radius));
+  writer.write(color);
   if (moving) {
-    serialize(buffer, velocity.x);
-    serialize(buffer, velocity.y);
+    writer.write(velocity.x);
+    writer.write(velocity.y);
   }
 }
 
@@ -122,7 +109,19 @@ void Cell::startMotion()
   m_motionStartedEmitter.emit();
 }
 
-void Cell::subscribeToDeath(void* tag, EventEmitter<>::Handler&& handler)
+void Cell::stopMotion()
+{
+  velocity.zero();
+  m_motionStoppedEmitter.emit();
+}
+
+bool Cell::isPredictable(double time, float threshold) const
+{
+  auto predicted = syncPosition + syncVelocity * static_cast<float>(time - syncTime);
+  return geometry::squareDistance(predicted, position) <= threshold * threshold;
+}
+
+void Cell::subscribeToDeath(void* tag, DeferredEmitter<>::Handler&& handler)
 {
   m_deathEmitter.subscribe(tag, std::move(handler));
 }
@@ -132,7 +131,7 @@ void Cell::unsubscribeFromDeath(void* tag)
   m_deathEmitter.unsubscribe(tag);
 }
 
-void Cell::subscribeToMassChange(void* tag, EventEmitter<float>::Handler&& handler)
+void Cell::subscribeToMassChange(void* tag, DeferredEmitter<float>::Handler&& handler)
 {
   m_massChangedEmitter.subscribe(tag, std::move(handler));
 }
@@ -142,12 +141,12 @@ void Cell::unsubscribeFromMassChange(void* tag)
   m_massChangedEmitter.unsubscribe(tag);
 }
 
-void Cell::subscribeToMotionStarted(void* tag, EventEmitter<>::Handler&& handler)
+void Cell::subscribeToMotionStarted(void* tag, DeferredEmitter<>::Handler&& handler)
 {
   m_motionStartedEmitter.subscribe(tag, std::move(handler));
 }
 
-void Cell::subscribeToMotionStopped(void* tag, EventEmitter<>::Handler&& handler)
+void Cell::subscribeToMotionStopped(void* tag, DeferredEmitter<>::Handler&& handler)
 {
   m_motionStoppedEmitter.subscribe(tag, std::move(handler));
 }
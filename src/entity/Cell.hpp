@@ -4,7 +4,9 @@
 #ifndef THEGAME_ENTITY_CELL_HPP
 #define THEGAME_ENTITY_CELL_HPP
 
-#include "../EventEmitter.hpp"
+#include "../CellStore.hpp"
+#include "../EventQueue.hpp"
+#include "../Gridmap.hpp"
 #include "../IEntityFactory.hpp"
 #include "../TimePoint.hpp"
 #include "../geometry/Circle.hpp"
@@ -16,7 +18,6 @@
 
 namespace asio = boost::asio;
 
-class Sector;
 class Player;
 class AABB;
 
@@ -37,10 +38,11 @@ public:
   virtual void modifyMass(float value);
   void modifyVelocity(const Vec2D& value);
 
-  void applyResistanceForce();
+  // Radius of the circle in which interact(Food&) can act: only food with the center strictly inside it is affected.
+  // Zero for cells that ignore food.
+  [[nodiscard]] virtual float getFoodReach() const;
 
   virtual bool intersects(const AABB& box);
-  virtual void simulate(double dt);
   virtual void format(Buffer& buffer);
 
   virtual void interact(Cell& cell);
@@ -55,13 +57,18 @@ public:
 
   void kill();
   void startMotion();
+  void stopMotion();
 
-  void subscribeToDeath(void* tag, EventEmitter<>::Handler&& handler);
+  // True while the position clients extrapolate from the last synced state (linearly, with the synced velocity) is
+  // within `threshold` of the real one.
+  [[nodiscard]] bool isPredictable(double time, float threshold) const;
+
+  void subscribeToDeath(void* tag, DeferredEmitter<>::Handler&& handler);
   void unsubscribeFromDeath(void* tag);
-  void subscribeToMassChange(void* tag, EventEmitter<float>::Handler&& handler);
+  void subscribeToMassChange(void* tag, DeferredEmitter<float>::Handler&& handler);
   void unsubscribeFromMassChange(void* tag);
-  void subscribeToMotionStarted(void* tag, EventEmitter<>::Handler&& handler);
-  void subscribeToMotionStopped(void* tag, EventEmitter<>::Handler&& handler);
+  void subscribeToMotionStarted(void* tag, DeferredEmitter<>::Handler&& handler);
+  void subscribeToMotionStopped(void* tag, DeferredEmitter<>::Handler&& handler);
 
   enum Type {
     typeAvatar = 1,
@@ -75,32 +82,38 @@ public:
     isMoving = 128
   };
 
-  std::set<Sector*> sectors;
-  Sector*           leftTopSector {nullptr};
-  Sector*           rightBottomSector {nullptr};
-  TimePoint         created {TimePoint::clock::now()};
-  Vec2D             velocity;
-  Vec2D             force;
-  Cell*             creator {nullptr};
-  Player*           player {nullptr};
-  float             mass {0};
-  float             resistanceRatio {0};
-  uint32_t          id {0};
-  uint32_t          type {0};
-  uint8_t           color {0};
-  bool              newly {true};
-  bool              zombie {false};
-  bool              materialPoint {false};
+  CellHandle              handle;
+  SectorSpan              sectors;
+  QuadtreeSlot            quadtreeSlot;
+  uint64_t                seenStamp {0};    // last Gridmap::collectPairs query that reported the cell
+  uint64_t                queryStamp {0};   // last Gridmap::collectPairs query issued for the cell
+  TimePoint               created {TimePoint::clock::now()};
+  Vec2D                   velocity;
+  Vec2D                   force;
+  Vec2D                   syncPosition;     // position and velocity at the last sync that sent the cell
+  Vec2D                   syncVelocity;
+  double                  syncTime {0};     // room time of that sync
+  CellHandle              creator;
+  Player*                 player {nullptr};
+  float                   mass {0};
+  float                   resistanceRatio {0};
+  uint32_t                id {0};
+  uint32_t                type {0};
+  uint8_t                 color {0};
+  uint8_t                 registries {0};   // membership bits of the room's CellRegistries
+  bool                    newly {true};
+  bool                    zombie {false};
+  bool                    materialPoint {false};
 
 protected:
   const config::Room&   m_config;
   IEntityFactory&       m_entityFactory;
 
 private:
-  EventEmitter<>        m_deathEmitter;
-  EventEmitter<float>   m_massChangedEmitter;
-  EventEmitter<>        m_motionStartedEmitter;
-  EventEmitter<>        m_motionStoppedEmitter;
+  DeferredEmitter<>       m_deathEmitter;
+  DeferredEmitter<float>  m_massChangedEmitter;
+  DeferredEmitter<>       m_motionStartedEmitter;
+  DeferredEmitter<>       m_motionStoppedEmitter;
 };
 
 #endif /* THEGAME_ENTITY_CELL_HPP */
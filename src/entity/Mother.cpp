@@ -31,6 +31,11 @@ Mother::Mother(
   );
 }
 
+float Mother::getFoodReach() const
+{
+  return radius;
+}
+
 void Mother::interact(Cell& cell)
 {
   cell.interact(*this);
@@ -43,7 +48,7 @@ void Mother::interact(Avatar& avatar)
 
 void Mother::interact(Food& food)
 {
-  if (food.creator == this && food.velocity) {
+  if (food.creator == handle && food.velocity) {
     return;
   }
   if (geometry::squareDistance(position, food.position) < radius * radius) {
@@ -107,7 +112,7 @@ void Mother::generateFood()
   for (int i = 0; i < foodToProduce; ++i) {
     const auto& direction = m_entityFactory.getRandomDirection();
     auto& obj = m_entityFactory.createFood();
-    obj.creator = this;
+    obj.creator = handle;
     obj.position = position + direction * radius;
     obj.color = m_foodColorIndexDistribution(generator);
     obj.modifyMass(m_config.food.mass);
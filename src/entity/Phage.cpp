@@ -23,6 +23,11 @@ Phage::Phage(
   color = config.phage.color;
 }
 
+float Phage::getFoodReach() const
+{
+  return radius + static_cast<float>(m_config.food.radius);
+}
+
 void Phage::interact(Cell& cell)
 {
   cell.interact(*this);
@@ -10,6 +10,8 @@ class Phage : public Cell {
 public:
   Phage(const asio::any_io_executor& executor, IEntityFactory& entityFactory, const config::Room& config, uint32_t id);
 
+  float getFoodReach() const override;
+
   void interact(Cell& cell) override;
   void interact(Avatar& avatar) override;
   void interact(Food& food) override;
@@ -23,6 +23,11 @@ Virus::Virus(
   color = config.virus.color;
 }
 
+float Virus::getFoodReach() const
+{
+  return radius + static_cast<float>(m_config.food.radius);
+}
+
 void Virus::interact(Cell& cell)
 {
   cell.interact(*this);
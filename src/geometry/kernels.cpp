@@ -0,0 +1,119 @@
+// file   : src/geometry/kernels.cpp
+// author : sba <bohdan.sadovyak@gmail.com>
+
+#include "kernels.hpp"
+
+#include "AABB.hpp"
+#include "Circle.hpp"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace geometry {
+
+uint64_t pointsInBox(const AABB& box, const float* xs, const float* ys, size_t count)
+{
+  uint64_t mask = 0;
+  size_t i = 0;
+#if defined(__AVX__)
+  const __m256 ax = _mm256_set1_ps(box.a.x);
+  const __m256 ay = _mm256_set1_ps(box.a.y);
+  const __m256 bx = _mm256_set1_ps(box.b.x);
+  const __m256 by = _mm256_set1_ps(box.b.y);
+  for (; i + 8 <= count; i += 8) {
+    const __m256 x = _mm256_loadu_ps(xs + i);
+    const __m256 y = _mm256_loadu_ps(ys + i);
+    const __m256 inside = _mm256_and_ps(
+      _mm256_and_ps(_mm256_cmp_ps(x, ax, _CMP_GE_OQ), _mm256_cmp_ps(x, bx, _CMP_LE_OQ)),
+      _mm256_and_ps(_mm256_cmp_ps(y, ay, _CMP_GE_OQ), _mm256_cmp_ps(y, by, _CMP_LE_OQ))
+    );
+    mask |= static_cast<uint64_t>(_mm256_movemask_ps(inside)) << i;
+  }
+#elif defined(__SSE2__)
+  const __m128 ax = _mm_set1_ps(box.a.x);
+  const __m128 ay = _mm_set1_ps(box.a.y);
+  const __m128 bx = _mm_set1_ps(box.b.x);
+  const __m128 by = _mm_set1_ps(box.b.y);
+  for (; i + 4 <= count; i += 4) {
+    const __m128 x = _mm_loadu_ps(xs + i);
+    const __m128 y = _mm_loadu_ps(ys + i);
+    const __m128 inside = _mm_and_ps(
+      _mm_and_ps(_mm_cmpge_ps(x, ax), _mm_cmple_ps(x, bx)),
+      _mm_and_ps(_mm_cmpge_ps(y, ay), _mm_cmple_ps(y, by))
+    );
+    mask |= static_cast<uint64_t>(_mm_movemask_ps(inside)) << i;
+  }
+#endif
+  for (; i < count; ++i) {
+    bool inside = xs[i] >= box.a.x && xs[i] <= box.b.x && ys[i] >= box.a.y && ys[i] <= box.b.y;
+    mask |= static_cast<uint64_t>(inside) << i;
+  }
+  return mask;
+}
+
+uint64_t pointsInCircle(const Circle& circle, const float* xs, const float* ys, size_t count)
+{
+  const float cx = circle.position.x;
+  const float cy = circle.position.y;
+  const float r2 = circle.radius * circle.radius;
+  uint64_t mask = 0;
+  size_t i = 0;
+#if defined(__AVX__)
+  for (; i + 8 <= count; i += 8) {
+    const __m256 a = _mm256_sub_ps(_mm256_set1_ps(cx), _mm256_loadu_ps(xs + i));
+    const __m256 b = _mm256_sub_ps(_mm256_set1_ps(cy), _mm256_loadu_ps(ys + i));
+    const __m256 d2 = _mm256_add_ps(_mm256_mul_ps(a, a), _mm256_mul_ps(b, b));
+    mask |= static_cast<uint64_t>(_mm256_movemask_ps(_mm256_cmp_ps(d2, _mm256_set1_ps(r2), _CMP_LT_OQ))) << i;
+  }
+#elif defined(__SSE2__)
+  for (; i + 4 <= count; i += 4) {
+    const __m128 a = _mm_sub_ps(_mm_set1_ps(cx), _mm_loadu_ps(xs + i));
+    const __m128 b = _mm_sub_ps(_mm_set1_ps(cy), _mm_loadu_ps(ys + i));
+    const __m128 d2 = _mm_add_ps(_mm_mul_ps(a, a), _mm_mul_ps(b, b));
+    mask |= static_cast<uint64_t>(_mm_movemask_ps(_mm_cmplt_ps(d2, _mm_set1_ps(r2)))) << i;
+  }
+#endif
+  for (; i < count; ++i) {
+    float a = cx - xs[i];
+    float b = cy - ys[i];
+    mask |= static_cast<uint64_t>(a * a + b * b < r2) << i;
+  }
+  return mask;
+}
+
+uint64_t circlesOverlapCircle(const Circle& circle, const float* xs, const float* ys, const float* rs, size_t count)
+{
+  const float cx = circle.position.x;
+  const float cy = circle.position.y;
+  uint64_t mask = 0;
+  size_t i = 0;
+#if defined(__AVX__)
+  for (; i + 8 <= count; i += 8) {
+    const __m256 a = _mm256_sub_ps(_mm256_set1_ps(cx), _mm256_loadu_ps(xs + i));
+    const __m256 b = _mm256_sub_ps(_mm256_set1_ps(cy), _mm256_loadu_ps(ys + i));
+    const __m256 r = _mm256_add_ps(_mm256_set1_ps(circle.radius), _mm256_loadu_ps(rs + i));
+    const __m256 d2 = _mm256_add_ps(_mm256_mul_ps(a, a), _mm256_mul_ps(b, b));
+    mask |= static_cast<uint64_t>(_mm256_movemask_ps(_mm256_cmp_ps(d2, _mm256_mul_ps(r, r), _CMP_LT_OQ))) << i;
+  }
+#elif defined(__SSE2__)
+  for (; i + 4 <= count; i += 4) {
+    const __m128 a = _mm_sub_ps(_mm_set1_ps(cx), _mm_loadu_ps(xs + i));
+    const __m128 b = _mm_sub_ps(_mm_set1_ps(cy), _mm_loadu_ps(ys + i));
+    const __m128 r = _mm_add_ps(_mm_set1_ps(circle.radius), _mm_loadu_ps(rs + i));
+    const __m128 d2 = _mm_add_ps(_mm_mul_ps(a, a), _mm_mul_ps(b, b));
+    mask |= static_cast<uint64_t>(_mm_movemask_ps(_mm_cmplt_ps(d2, _mm_mul_ps(r, r)))) << i;
+  }
+#endif
+  for (; i < count; ++i) {
+    float a = cx - xs[i];
+    float b = cy - ys[i];
+    float r = circle.radius + rs[i];
+    mask |= static_cast<uint64_t>(a * a + b * b < r * r) << i;
+  }
+  return mask;
+}
+
+} // namespace geometry
@@ -0,0 +1,33 @@
+// file   : src/geometry/kernels.hpp
+// author : sba <bohdan.sadovyak@gmail.com>
+
+#ifndef THEGAME_GEOMETRY_KERNELS_HPP
+#define THEGAME_GEOMETRY_KERNELS_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+class AABB;
+class Circle;
+
+namespace geometry {
+
+// Batch versions of the tests in geometry.hpp over packed (SoA) coordinates. Each call handles up to 64 items and
+// returns a mask with bit i set for a hit on item i. Uses AVX or SSE2 when the target has them, with a scalar tail
+// and fallback. Results are bit-identical to the scalar tests: distances are computed exactly as squareDistance does
+// and the build keeps floating-point contraction off.
+
+constexpr size_t KernelBatchSize = 64;
+
+// Points inside the box, borders included (same as intersects(box, point)).
+uint64_t pointsInBox(const AABB& box, const float* xs, const float* ys, size_t count);
+
+// Points strictly inside the circle: squareDistance(circle.position, point) < radius * radius.
+uint64_t pointsInCircle(const Circle& circle, const float* xs, const float* ys, size_t count);
+
+// Circles overlapping the circle: squareDistance(circle.position, center) < (radius + rs[i]) * (radius + rs[i]).
+uint64_t circlesOverlapCircle(const Circle& circle, const float* xs, const float* ys, const float* rs, size_t count);
+
+} // namespace geometry
+
+#endif /* THEGAME_GEOMETRY_KERNELS_HPP */
@@ -9,8 +9,12 @@
 #include <boost/beast/core/flat_buffer.hpp>
 #include <boost/endian/conversion.hpp>
 
+#include <bit>
+#include <cassert>
+#include <cstring>
 #include <stdexcept>
 #include <string>
+#include <type_traits>
 
 namespace beast = boost::beast;
 
@@ -36,6 +40,62 @@ inline void serialize<float>(Buffer& buffer, const float& data)
   serialize(buffer, u.i);
 }
 
+// LEB128: 7 bits per byte, least significant group first, the high bit set on all bytes but the last.
+inline void serializeVarint(Buffer& buffer, uint32_t value)
+{
+  while (value >= 0x80) {
+    buffer.push_back(static_cast<char>(value | 0x80));
+    value >>= 7;
+  }
+  buffer.push_back(static_cast<char>(value));
+}
+
+// Writes a record of bounded size through a raw cursor: the buffer grows once by `capacity` bytes when the writer is
+// created and is cut back to what was written when it is destroyed, instead of an insert per field.
+class BufferWriter {
+public:
+  BufferWriter(Buffer& buffer, size_t capacity) : m_buffer(buffer)
+  {
+    auto offset = buffer.size();
+    buffer.resize(offset + capacity);
+    m_cursor = buffer.data() + offset;
+    m_end = buffer.data() + buffer.size();
+  }
+
+  BufferWriter(const BufferWriter&) = delete;
+  BufferWriter& operator=(const BufferWriter&) = delete;
+
+  ~BufferWriter() { m_buffer.resize(m_cursor - m_buffer.data()); }
+
+  template <typename T>
+  void write(T value)
+  {
+    if constexpr (std::is_same_v<T, float>) {
+      write(std::bit_cast<uint32_t>(value));
+    } else {
+      assert(m_cursor + sizeof(T) <= m_end);
+      value = boost::endian::native_to_big(value);
+      std::memcpy(m_cursor, &value, sizeof(T));
+      m_cursor += sizeof(T);
+    }
+  }
+
+  void writeVarint(uint32_t value)
+  {
+    assert(m_cursor + 5 <= m_end);
+    while (value >= 0x80) {
+      *m_cursor++ = static_cast<char>(value | 0x80);
+      value >>= 7;
+    }
+    *m_cursor++ = static_cast<char>(value);
+  }
+
+private:
+  Buffer& m_buffer;
+  char*   m_cursor;
+  char*   m_end;
+};
+
 template <typename T>
 T deserialize(beast::flat_buffer& buffer)
 {
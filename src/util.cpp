@@ -3,20 +3,28 @@
 
 #include "util.hpp"
 
-#include <chrono>
-#include <algorithm>
-#include <random>
+#include <openssl/rand.h>
+
+#include <stdexcept>
 
 std::string randomString(size_t length)
 {
   constexpr char charset[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
-  std::random_device generator;
-  std::uniform_int_distribution<uint> distribution(0, sizeof(charset) - 2);
-  auto randchar = [&]() -> char
-  {
-    return charset[distribution(generator)];
-  };
-  std::string str(length, 0);
-  std::generate_n(str.begin(), length, randchar);
+  constexpr unsigned charsetSize = sizeof(charset) - 1;
+  constexpr unsigned limit = 256 / charsetSize * charsetSize; // bytes from here on would favour the first characters
+  // OpenSSL's CSPRNG is seeded once per process, unlike a std::random_device opened for every string
+  unsigned char bytes[64];
+  std::string str;
+  str.reserve(length);
+  while (str.size() < length) {
+    if (RAND_bytes(bytes, sizeof(bytes)) != 1) {
+      throw std::runtime_error("Failed to generate random bytes");
+    }
+    for (auto byte : bytes) {
+      if (byte < limit && str.size() < length) {
+        str.push_back(charset[byte % charsetSize]);
+      }
+    }
+  }
   return str;
 }
@@ -0,0 +1,134 @@
+// file   : tests/Benchmark_Deflate.cpp
+// author : sba <bohdan.sadovyak@gmail.com>
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include "DefaultRoomConfig.hpp"
+#include "Deflater.hpp"
+#include "EntityFactoryStub.hpp"
+#include "OutgoingPacket.hpp"
+#include "serialization.hpp"
+
+#include <fmt/format.h>
+
+#include <vector>
+
+namespace {
+
+constexpr int Viewers = 50;
+
+// Stand-in for recorded traffic: the Frame payloads 50 viewers of the default room would get (every cell in view, as
+// on the first frame after moving to new sectors) and leaderboard broadcasts of 20 entries.
+struct Traffic {
+  explicit Traffic(EntityFactoryStub& factory, const config::Room& config)
+  {
+    auto& engine = factory.engine();
+    std::vector<Cell*> cells;
+    std::uniform_real_distribution<float> velocity(-300, 300);
+    for (uint32_t i = 0; i < config.food.maxQuantity; ++i) {
+      auto& food = factory.createFood();
+      food.setMass(config.food.mass);
+      food.position = factory.getRandomPosition(food.radius);
+      if (i % 10 == 0) {
+        food.velocity = {velocity(engine), velocity(engine)};
+      }
+      cells.push_back(&food);
+    }
+    for (uint32_t i = 0; i < config.virus.quantity; ++i) {
+      auto& virus = factory.createVirus();
+      virus.setMass(config.virus.mass);
+      virus.position = factory.getRandomPosition(virus.radius);
+      cells.push_back(&virus);
+    }
+    for (auto* cell : cells) {
+      factory.getGridmap().insert(cell);
+    }
+
+    const Vec2D viewport(config.viewportBase * config.aspectRatio, config.viewportBase);
+    for (int i = 0; i < Viewers; ++i) {
+      auto corner = factory.getRandomPosition(0);
+      auto& frame = frames.emplace_back();
+      serialize(frame, OutgoingPacket::Type::Frame);
+      factory.getGridmap().query(AABB(corner, corner + viewport), [&](Cell& cell) {
+        cell.format(frame);
+        return true;
+      });
+    }
+
+    std::uniform_int_distribution<uint32_t> mass(250, 50000);
+    for (int i = 0; i < 10; ++i) {
+      auto& leaderboard = leaderboards.emplace_back();
+      serialize(leaderboard, OutgoingPacket::Type::Leaderboard);
+      serialize(leaderboard, uint8_t{20});
+      for (uint32_t id = 1; id <= 20; ++id) {
+        serialize(leaderboard, id);
+        serialize(leaderboard, mass(engine));
+      }
+    }
+  }
+
+  std::vector<Buffer> frames;
+  std::vector<Buffer> leaderboards;
+};
+
+size_t totalSize(const std::vector<Buffer>& packets)
+{
+  size_t size = 0;
+  for (const auto& packet : packets) {
+    size += packet.size();
+  }
+  return size;
+}
+
+} // namespace
+
+TEST_CASE("Deflate: CPU vs bandwidth on room traffic", "[.][benchmark][Deflate]")
+{
+  auto config = getDefaultRoomConfig();
+  EntityFactoryStub factory(config);
+  Traffic traffic(factory, config);
+
+  for (int level : {1, 6, 9}) {
+    Deflater deflater(level);
+    for (const auto* packets : {&traffic.frames, &traffic.leaderboards}) {
+      Buffer out;
+      for (const auto& packet : *packets) {
+        deflater.compress(packet.data(), packet.size(), out);
+      }
+      fmt::print("level {}: {} {} bytes -> {} bytes ({:.0f}%)\n",
+        level, packets == &traffic.frames ? "frames" : "leaderboards", totalSize(*packets), out.size(),
+        100.0 * static_cast<double>(out.size()) / static_cast<double>(totalSize(*packets))
+      );
+    }
+
+    BENCHMARK(fmt::format("{} frames, level {}", Viewers, level).c_str())
+    {
+      Buffer out;
+      for (const auto& frame : traffic.frames) {
+        deflater.compress(frame.data(), frame.size(), out);
+      }
+      return out.size();
+    };
+  }
+
+  // a broadcast deflated by every session's websocket vs deflated once by the room
+  Deflater deflater;
+  const auto& leaderboard = traffic.leaderboards.front();
+  BENCHMARK(fmt::format("leaderboard to {} sessions, deflated per session", Viewers).c_str())
+  {
+    size_t size = 0;
+    for (int i = 0; i < Viewers; ++i) {
+      Buffer out;
+      deflater.compress(leaderboard.data(), leaderboard.size(), out);
+      size += out.size();
+    }
+    return size;
+  };
+  BENCHMARK(fmt::format("leaderboard to {} sessions, deflated once", Viewers).c_str())
+  {
+    Buffer out;
+    OutgoingPacket::serializeCompressed(out, leaderboard, deflater);
+    return out.size();
+  };
+}
@@ -0,0 +1,94 @@
+// file   : tests/Benchmark_EventQueue.cpp
+// author : sba <bohdan.sadovyak@gmail.com>
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include "EventEmitter.hpp"
+#include "EventQueue.hpp"
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/strand.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace {
+
+// Events of a tick in which avatars eat food: every eaten food dies (Room and Player-like subscribers), the eater's
+// mass changes, and a third of the food was moving and stops.
+constexpr int FoodEaten = 200;
+constexpr int Avatars = 20;
+
+template <template <typename...> typename Emitter, typename Source>
+struct Cells {
+  struct Cell {
+    explicit Cell(Source& game, Source& death) : death(death), massChange(game), motionStopped(game) {}
+
+    Emitter<>       death;
+    Emitter<float>  massChange;
+    Emitter<>       motionStopped;
+  };
+
+  Cells(Source& game, Source& death, int count)
+  {
+    for (int i = 0; i < count; ++i) {
+      auto& cell = *items.emplace_back(std::make_unique<Cell>(game, death));
+      cell.death.subscribe(this, [this] { ++deaths; });
+      cell.death.subscribe(&deaths, [this] { ++deaths; });
+      cell.massChange.subscribe(this, [this](float delta) { mass += delta; });
+      cell.motionStopped.subscribe(this, [this] { ++stops; });
+    }
+  }
+
+  void tick()
+  {
+    for (int i = 0; i < FoodEaten; ++i) {
+      items[i % Avatars]->massChange.emit(1.0f);
+      if (i % 3 == 0) {
+        items[Avatars + i]->motionStopped.emit();
+      }
+      items[Avatars + i]->death.emit();
+    }
+  }
+
+  std::vector<std::unique_ptr<Cell>>  items;
+  int                                 deaths {0};
+  int                                 stops {0};
+  float                               mass {0};
+};
+
+} // namespace
+
+TEST_CASE("Cell events: asio::post emitter vs deferred queue", "[.][benchmark]")
+{
+  BENCHMARK_ADVANCED("EventEmitter, posted to strands")(Catch::Benchmark::Chronometer meter)
+  {
+    asio::io_context gameContext;
+    asio::io_context deathContext;
+    asio::any_io_executor game {asio::make_strand(gameContext)};
+    asio::any_io_executor death {asio::make_strand(deathContext)};
+    Cells<EventEmitter, asio::any_io_executor> cells(game, death, Avatars + FoodEaten);
+    meter.measure([&] {
+      cells.tick();
+      gameContext.run();
+      gameContext.restart();
+      deathContext.run();
+      deathContext.restart();
+      return cells.deaths;
+    });
+  };
+
+  BENCHMARK_ADVANCED("DeferredEmitter, flushed queues")(Catch::Benchmark::Chronometer meter)
+  {
+    EventQueue game;
+    EventQueue death;
+    Cells<DeferredEmitter, EventQueue> cells(game, death, Avatars + FoodEaten);
+    meter.measure([&] {
+      cells.tick();
+      game.flush();
+      death.flush();
+      return cells.deaths;
+    });
+  };
+}
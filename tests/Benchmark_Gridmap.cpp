@@ -0,0 +1,162 @@
+// file   : tests/Benchmark_Gridmap.cpp
+// author : sba <bohdan.sadovyak@gmail.com>
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include "DefaultRoomConfig.hpp"
+#include "EntityFactoryStub.hpp"
+
+#include <fmt/format.h>
+
+namespace {
+
+// Fills the stub with the default room population: food up to maxQuantity, viruses, phages, mothers and maxPlayers
+// avatars. The sequence only depends on the config, so stubs populated with the same config hold identical cells.
+std::vector<Cell*> populateDefaultRoom(EntityFactoryStub& factory, const config::Room& config, float maxAvatarMass = 5000)
+{
+  std::vector<Cell*> cells;
+  std::uniform_real_distribution<float> avatarMass(config.player.mass, maxAvatarMass);
+  for (uint32_t i = 0; i < config.food.maxQuantity; ++i) {
+    auto& obj = factory.createFood();
+    obj.position = factory.getRandomPosition(obj.radius);
+    obj.setMass(config.food.mass);
+    cells.push_back(&obj);
+  }
+  for (uint32_t i = 0; i < config.virus.quantity; ++i) {
+    auto& obj = factory.createVirus();
+    obj.setMass(config.virus.mass);
+    obj.position = factory.getRandomPosition(obj.radius);
+    cells.push_back(&obj);
+  }
+  for (uint32_t i = 0; i < config.phage.quantity; ++i) {
+    auto& obj = factory.createPhage();
+    obj.setMass(config.phage.mass);
+    obj.position = factory.getRandomPosition(obj.radius);
+    cells.push_back(&obj);
+  }
+  for (uint32_t i = 0; i < config.mother.quantity; ++i) {
+    auto& obj = factory.createMother();
+    obj.setMass(config.mother.mass);
+    obj.position = factory.getRandomPosition(obj.radius);
+    cells.push_back(&obj);
+  }
+  for (uint32_t i = 0; i < config.maxPlayers; ++i) {
+    auto& obj = factory.createAvatar();
+    obj.setMass(avatarMass(factory.engine()));
+    obj.position = factory.getRandomPosition(obj.radius);
+    cells.push_back(&obj);
+  }
+  for (auto* cell : cells) {
+    factory.getGridmap().insert(cell);
+  }
+  return cells;
+}
+
+} // namespace
+
+TEST_CASE("Gridmap query: std::function vs template vs batch", "[.][benchmark][Gridmap]")
+{
+  auto config = getDefaultRoomConfig();
+  EntityFactoryStub factory(config, 9);
+  const auto& gridmap = factory.getGridmap();
+  const auto& cells = populateDefaultRoom(factory, config);
+
+  std::vector<Cell*> avatars;
+  for (auto* cell : cells) {
+    if (cell->type == Cell::typeAvatar) {
+      avatars.push_back(cell);
+    }
+  }
+
+  BENCHMARK("std::function handler")
+  {
+    float mass = 0;
+    for (auto* avatar : avatars) {
+      const Gridmap::Handler handler = [&](Cell& target) {
+        mass += target.mass;
+        return true;
+      };
+      gridmap.query(avatar->getAABB(), handler);
+    }
+    return mass;
+  };
+
+  BENCHMARK("template handler")
+  {
+    float mass = 0;
+    for (auto* avatar : avatars) {
+      gridmap.query(avatar->getAABB(), [&](Cell& target) {
+        mass += target.mass;
+        return true;
+      });
+    }
+    return mass;
+  };
+
+  std::vector<Cell*> buffer;
+  BENCHMARK("batch into reusable buffer")
+  {
+    float mass = 0;
+    for (auto* avatar : avatars) {
+      gridmap.collect(avatar->getAABB(), buffer);
+      for (auto* target : buffer) {
+        mass += target->mass;
+      }
+    }
+    return mass;
+  };
+}
+
+TEST_CASE("Gridmap vs loose quadtree: broad phase replay", "[.][benchmark][Gridmap]")
+{
+  struct Scenario {
+    uint32_t  size;
+    uint32_t  food;
+    float     maxAvatarMass;
+  };
+
+  for (const auto& scenario : {Scenario{6144, 5000, 5000}, Scenario{6144, 5000, 50000}, Scenario{16384, 35000, 50000}}) {
+    auto config = getDefaultRoomConfig();
+    config.width = config.height = scenario.size;
+    config.food.maxQuantity = scenario.food;
+
+    for (auto index : {Gridmap::Index::Grid, Gridmap::Index::Quadtree}) {
+      EntityFactoryStub factory(config, index == Gridmap::Index::Grid ? 9 : 8, index);
+      auto& gridmap = factory.getGridmap();
+      const auto& cells = populateDefaultRoom(factory, config, scenario.maxAvatarMass);
+
+      // every avatar and a tenth of the rest move back and forth, as in a tick with ejected and generated food; a step
+      // is the broad phase plus the food pass of Room::update
+      std::vector<Cell*> moving;
+      for (size_t i = 0; i < cells.size(); ++i) {
+        if (cells[i]->type == Cell::typeAvatar || i % 10 == 0) {
+          moving.push_back(cells[i]);
+        }
+      }
+
+      auto name = fmt::format("{} {}x{} food={} maxAvatarMass={}",
+        index == Gridmap::Index::Grid ? "grid" : "quadtree", scenario.size, scenario.size, scenario.food,
+        scenario.maxAvatarMass
+      );
+      Gridmap::CellPairs pairs;
+      float step = 7;
+      BENCHMARK(name.c_str())
+      {
+        step = -step;
+        for (auto* cell : moving) {
+          cell->position.x += step;
+          gridmap.update(cell);
+        }
+        gridmap.collectPairs(moving, pairs);
+        size_t food = 0;
+        for (auto* cell : moving) {
+          if (auto reach = cell->getFoodReach(); reach > 0) {
+            gridmap.queryPoints(Circle(cell->position, reach), cell->getAABB(), [&](Cell&) { ++food; return true; });
+          }
+        }
+        return pairs.size() + food;
+      };
+    }
+  }
+}
@@ -0,0 +1,86 @@
+// file   : tests/EntityFactoryStub.hpp
+// author : sba <bohdan.sadovyak@gmail.com>
+
+#ifndef THEGAME_TESTS_ENTITY_FACTORY_STUB_HPP
+#define THEGAME_TESTS_ENTITY_FACTORY_STUB_HPP
+
+#include "CellStore.hpp"
+#include "Config.hpp"
+#include "EventQueue.hpp"
+#include "Gridmap.hpp"
+#include "IEntityFactory.hpp"
+#include "NextId.hpp"
+
+#include "entity/Avatar.hpp"
+#include "entity/Bullet.hpp"
+#include "entity/Food.hpp"
+#include "entity/Mother.hpp"
+#include "entity/Phage.hpp"
+#include "entity/Virus.hpp"
+
+#include "geometry/Vec2D.hpp"
+
+#include <boost/asio/io_context.hpp>
+
+#include <memory>
+#include <vector>
+
+// Minimal IEntityFactory for unit tests and benchmarks: creates cells without any Room bookkeeping.
+class EntityFactoryStub : public IEntityFactory {
+public:
+  explicit EntityFactoryStub(const config::Room& config, uint8_t power = 9, Gridmap::Index index = Gridmap::Index::Grid)
+    : m_config(config)
+  {
+    m_gridmap.resize(m_config.width, m_config.height, power, index);
+  }
+
+  Avatar& createAvatar() override { return create<Avatar>(); }
+  Food& createFood() override { return create<Food>(); }
+  Bullet& createBullet() override { return create<Bullet>(); }
+  Virus& createVirus() override { return create<Virus>(); }
+  Phage& createPhage() override { return create<Phage>(); }
+  Mother& createMother() override { return create<Mother>(); }
+
+  std::random_device& randomGenerator() override { return m_generator; }
+
+  Vec2D getRandomPosition(double radius) const override
+  {
+    std::uniform_real_distribution<float> x(radius, m_config.width - radius);
+    std::uniform_real_distribution<float> y(radius, m_config.height - radius);
+    return {x(m_engine), y(m_engine)};
+  }
+
+  Vec2D getRandomDirection() const override { return {1, 0}; }
+  Gridmap& getGridmap() override { return m_gridmap; }
+  PlayerPtr getTopPlayer() const override { return {}; }
+  EventQueue& getGameEvents() override { return m_gameEvents; }
+  EventQueue& getDeathEvents() override { return m_deathEvents; }
+
+  std::mt19937& engine() { return m_engine; }
+  CellStore& store() { return m_store; }
+
+private:
+  template <typename T>
+  T& create()
+  {
+    auto cell = std::make_unique<T>(m_executor, *this, m_config, m_nextId.pop());
+    auto& result = *cell;
+    m_store.add(&result);
+    m_cells.emplace_back(std::move(cell));
+    return result;
+  }
+
+  const config::Room&                 m_config;
+  std::random_device                  m_generator;
+  mutable std::mt19937                m_engine {1};
+  asio::io_context                    m_ioContext;
+  asio::any_io_executor               m_executor {m_ioContext.get_executor()};
+  Gridmap                             m_gridmap;
+  EventQueue                          m_gameEvents;
+  EventQueue                          m_deathEvents;
+  CellStore                           m_store;
+  NextId                              m_nextId;
+  std::vector<std::unique_ptr<Cell>>  m_cells;
+};
+
+#endif /* THEGAME_TESTS_ENTITY_FACTORY_STUB_HPP */
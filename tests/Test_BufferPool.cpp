@@ -0,0 +1,94 @@
+// file   : tests/Test_BufferPool.cpp
+// author : sba <bohdan.sadovyak@gmail.com>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "BufferPool.hpp"
+#include "serialization.hpp"
+
+#include <thread>
+#include <vector>
+
+TEST_CASE("BufferPool: released buffers are reused empty with their capacity", "[BufferPool]")
+{
+  BufferPool pool;
+
+  auto buffer = pool.acquire(1000);
+  REQUIRE(buffer->empty());
+  REQUIRE(buffer->capacity() >= 1000);
+  buffer->resize(500);
+  const auto* data = buffer->data();
+  buffer.reset();
+
+  auto reused = pool.acquire();
+  REQUIRE(reused->empty());
+  REQUIRE(reused->capacity() >= 1000);
+  REQUIRE(reused->data() == data);
+
+  auto stats = pool.getStats();
+  REQUIRE(stats.acquired == 2);
+  REQUIRE(stats.allocated == 1);
+  REQUIRE(stats.idle == 0);
+}
+
+TEST_CASE("BufferPool: a warm pool allocates no more buffers", "[BufferPool]")
+{
+  BufferPool pool;
+
+  for (int round = 0; round < 100; ++round) {
+    std::vector<BufferPtr> buffers;
+    for (int i = 0; i < 16; ++i) {
+      buffers.emplace_back(pool.acquire(64));
+      serialize(*buffers.back(), static_cast<uint32_t>(i));
+    }
+  }
+  auto stats = pool.getStats();
+  REQUIRE(stats.acquired == 1600);
+  REQUIRE(stats.allocated == 16);
+  REQUIRE(stats.idle == 16);
+}
+
+TEST_CASE("BufferPool: oversized buffers are not kept", "[BufferPool]")
+{
+  BufferPool pool;
+
+  pool.acquire(BufferPool::MaxCapacity + 1);
+  REQUIRE(pool.getStats().idle == 0);
+}
+
+TEST_CASE("BufferPool: buffers can be released on another thread", "[BufferPool]")
+{
+  BufferPool pool;
+
+  for (int round = 0; round < 10; ++round) {
+    std::vector<BufferPtr> buffers;
+    for (int i = 0; i < 100; ++i) {
+      buffers.emplace_back(pool.acquire(128));
+    }
+    std::thread writer([buffers = std::move(buffers)]() mutable { buffers.clear(); });
+    writer.join();
+  }
+  auto stats = pool.getStats();
+  REQUIRE(stats.allocated == 100);
+  REQUIRE(stats.idle == 100);
+}
+
+TEST_CASE("BufferWriter: writes the same bytes as serialize", "[BufferPool]")
+{
+  Buffer expected;
+  serialize(expected, static_cast<uint8_t>(7));
+  serialize(expected, static_cast<uint16_t>(0x1234));
+  serialize(expected, 3.5f);
+  serializeVarint(expected, 300);
+
+  Buffer buffer {'x'};
+  {
+    BufferWriter writer(buffer, 16);
+    writer.write(static_cast<uint8_t>(7));
+    writer.write(static_cast<uint16_t>(0x1234));
+    writer.write(3.5f);
+    writer.writeVarint(300);
+  }
+  REQUIRE(buffer.size() == expected.size() + 1);
+  REQUIRE(Buffer(buffer.begin() + 1, buffer.end()) == expected);
+}
@@ -0,0 +1,63 @@
+// file   : tests/Test_CellRegistry.cpp
+// author : sba <bohdan.sadovyak@gmail.com>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "CellRegistry.hpp"
+#include "DefaultRoomConfig.hpp"
+#include "EntityFactoryStub.hpp"
+
+#include <algorithm>
+
+TEST_CASE("CellRegistry: membership without duplicates", "[CellRegistry]")
+{
+  auto config = getDefaultRoomConfig();
+  EntityFactoryStub factory(config);
+  CellRegistry modified(0);
+  CellRegistry created(1);
+
+  auto& a = factory.createFood();
+  auto& b = factory.createAvatar();
+  auto& c = factory.createVirus();
+
+  REQUIRE(modified.insert(&a));
+  REQUIRE(modified.insert(&b));
+  REQUIRE_FALSE(modified.insert(&a));
+  REQUIRE(created.insert(&a));
+  REQUIRE(modified.size() == 2);
+  REQUIRE(modified.contains(&a));
+  REQUIRE_FALSE(modified.contains(&c));
+  REQUIRE(modified.cells() == std::vector<Cell*> {&a, &b});
+
+  // erased and inserted again before compaction: still listed once
+  modified.erase(&a);
+  REQUIRE_FALSE(modified.contains(&a));
+  REQUIRE(created.contains(&a));
+  REQUIRE(modified.size() == 1);
+  modified.insert(&a);
+  modified.insert(&c);
+  REQUIRE(modified.cells() == std::vector<Cell*> {&a, &b, &c});
+
+  modified.erase(&b);
+  modified.erase(&b);
+  REQUIRE(modified.size() == 2);
+  REQUIRE(modified.cells() == std::vector<Cell*> {&a, &c});
+
+  modified.clear();
+  REQUIRE(modified.empty());
+  REQUIRE(modified.cells().empty());
+  REQUIRE_FALSE(modified.contains(&a));
+  REQUIRE(created.cells() == std::vector<Cell*> {&a});
+
+  // after compaction the erased cell is no longer referenced
+  created.erase(&a);
+  created.compact();
+  REQUIRE(a.registries == 0);
+  REQUIRE(b.registries == 0);
+  REQUIRE(c.registries == 0);
+}
+
+TEST_CASE("CellRegistry: invalid index", "[CellRegistry]")
+{
+  REQUIRE_THROWS_AS(CellRegistry(CellRegistry::MaxRegistries), std::invalid_argument);
+}
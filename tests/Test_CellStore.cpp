@@ -0,0 +1,190 @@
+// file   : tests/Test_CellStore.cpp
+// author : sba <bohdan.sadovyak@gmail.com>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "DefaultRoomConfig.hpp"
+#include "EntityFactoryStub.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+namespace {
+
+struct Kinematics {
+  Vec2D position;
+  Vec2D velocity;
+  bool  forced {false};
+  bool  stopped {false};
+};
+
+// The per-cell physics step CellStore::integrate replaces, written with the Vec2D operators.
+Kinematics reference(const Cell& cell, double dt)
+{
+  auto force = cell.force - cell.velocity.direction() * (cell.radius * cell.resistanceRatio);
+  Kinematics result {cell.position, cell.velocity, static_cast<bool>(force)};
+  auto prevVelocity = result.velocity;
+  result.velocity += force / cell.mass * dt;
+  if (std::fabs(1 + result.velocity.direction() * prevVelocity.direction()) <= 0.01) {
+    result.velocity.zero();
+    result.stopped = true;
+  } else {
+    result.position += result.velocity * dt;
+  }
+  return result;
+}
+
+} // namespace
+
+TEST_CASE("CellStore: handles resolve only while the cell is alive", "[CellStore]")
+{
+  auto config = getDefaultRoomConfig();
+  EntityFactoryStub factory(config);
+  auto& store = factory.store();
+
+  auto& a = factory.createFood();
+  auto& b = factory.createAvatar();
+  auto handleA = a.handle;
+  auto handleB = b.handle;
+  REQUIRE(store.size() == 2);
+  REQUIRE(store.get(handleA) == &a);
+  REQUIRE(store.get(handleB) == &b);
+  REQUIRE(a.handle == handleA);
+
+  store.remove(&a);
+  REQUIRE(store.size() == 1);
+  REQUIRE(store.get(handleA) == nullptr);
+  REQUIRE(store.get(handleB) == &b);
+  REQUIRE(a.handle.empty());
+
+  // the slot is reused with a new generation, the old handle stays dead
+  auto& c = factory.createFood();
+  auto handleC = c.handle;
+  REQUIRE(handleC.index == handleA.index);
+  REQUIRE(handleC != handleA);
+  REQUIRE(store.get(handleA) == nullptr);
+  REQUIRE(store.get(handleC) == &c);
+  REQUIRE(store.get(CellHandle{}) == nullptr);
+
+  std::vector<Cell*> cells(store.begin(), store.end());
+  REQUIRE(cells.size() == 2);
+  REQUIRE(std::ranges::count(cells, &b) == 1);
+  REQUIRE(std::ranges::count(cells, &c) == 1);
+}
+
+TEST_CASE("CellStore: motion table", "[CellStore]")
+{
+  auto config = getDefaultRoomConfig();
+  EntityFactoryStub factory(config);
+  auto& store = factory.store();
+
+  std::vector<Cell*> cells;
+  for (int i = 0; i < 5; ++i) {
+    cells.push_back(&factory.createAvatar());
+  }
+  for (auto* cell : cells) {
+    store.startMotion(cell);
+    store.startMotion(cell);
+  }
+  REQUIRE(store.moving().size() == 5);
+
+  store.stopMotion(cells[1]);
+  store.stopMotion(cells[1]);
+  REQUIRE(store.moving().size() == 4);
+  REQUIRE_FALSE(store.isMoving(cells[1]));
+  REQUIRE(store.isMoving(cells[4]));
+
+  store.remove(cells[0]);
+  REQUIRE(store.moving().size() == 3);
+  REQUIRE_FALSE(store.isMoving(cells[0]));
+  for (auto* cell : {cells[2], cells[3], cells[4]}) {
+    REQUIRE(std::ranges::count(store.moving(), cell) == 1);
+  }
+}
+
+TEST_CASE("CellStore: integrate matches the per-cell physics", "[CellStore]")
+{
+  auto config = getDefaultRoomConfig();
+  EntityFactoryStub factory(config);
+  auto& store = factory.store();
+  std::uniform_real_distribution<float> mass(1, 5000);
+  std::uniform_real_distribution<float> component(-500, 500);
+  auto& engine = factory.engine();
+
+  std::vector<Cell*> cells;
+  for (int i = 0; i < 200; ++i) {
+    auto& cell = i % 2 ? static_cast<Cell&>(factory.createAvatar()) : factory.createBullet();
+    cell.setMass(mass(engine));
+    cell.position = factory.getRandomPosition(cell.radius);
+    cell.velocity = i % 7 ? Vec2D(component(engine), component(engine)) : Vec2D();
+    cell.force = i % 3 ? Vec2D(component(engine), component(engine)) * 1000 : Vec2D();
+    if (i % 11 == 0) {
+      // a force that reverses the velocity stops the cell
+      cell.force = -cell.velocity * (cell.mass * 100);
+    }
+    store.startMotion(&cell);
+    cells.push_back(&cell);
+  }
+
+  const double dt = 0.04;
+  std::unordered_map<Cell*, Kinematics> expected;
+  for (auto* cell : cells) {
+    expected[cell] = reference(*cell, dt);
+  }
+  store.integrate(dt);
+
+  size_t stopped = 0;
+  const auto& moving = store.moving();
+  for (size_t row = 0; row < moving.size(); ++row) {
+    auto* cell = moving[row];
+    const auto& kinematics = expected[cell];
+    REQUIRE(cell->position == kinematics.position);
+    REQUIRE(cell->velocity == kinematics.velocity);
+    REQUIRE(cell->force == Vec2D());
+    REQUIRE(store.forced(row) == kinematics.forced);
+    REQUIRE(store.stopped(row) == kinematics.stopped);
+    stopped += kinematics.stopped;
+  }
+  REQUIRE(stopped > 0);
+}
+
+TEST_CASE("CellStore: dead reckoning resends a decelerating cell only on drift", "[CellStore]")
+{
+  auto config = getDefaultRoomConfig();
+  EntityFactoryStub factory(config);
+  auto& store = factory.store();
+
+  auto& bullet = factory.createBullet();
+  bullet.setMass(100);
+  bullet.position = {1000, 1000};
+  bullet.velocity = {800, 0};
+  bullet.syncPosition = bullet.position;
+  bullet.syncVelocity = bullet.velocity;
+  store.startMotion(&bullet);
+
+  const double dt = 0.02;
+  const float threshold = 5;
+  double time = 0;
+  int steps = 0;
+  int resends = 0;
+  while (store.isMoving(&bullet) && steps < 1000) {
+    store.integrate(dt);
+    time += dt;
+    ++steps;
+    if (store.stopped(0)) {
+      store.stopMotion(&bullet);
+    } else if (!bullet.isPredictable(time, threshold)) {
+      ++resends;
+      bullet.syncPosition = bullet.position;
+      bullet.syncVelocity = bullet.velocity;
+      bullet.syncTime = time;
+    }
+    auto predicted = bullet.syncPosition + bullet.syncVelocity * static_cast<float>(time - bullet.syncTime);
+    REQUIRE((predicted - bullet.position).length() <= threshold);
+  }
+  INFO("steps " << steps << " resends " << resends);
+  REQUIRE(steps > 10);
+  REQUIRE(resends > 0);
+  REQUIRE(resends * 3 < steps);
+}
@@ -0,0 +1,197 @@
+// file   : tests/Test_DeltaEncoder.cpp
+// author : sba <bohdan.sadovyak@gmail.com>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "DefaultRoomConfig.hpp"
+#include "DeltaEncoder.hpp"
+#include "EntityFactoryStub.hpp"
+#include "serialization.hpp"
+
+#include <boost/endian/conversion.hpp>
+
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+namespace {
+
+struct Decoded {
+  float     x {0};
+  float     y {0};
+  uint32_t  mass {0};
+  uint32_t  radius {0};
+  uint8_t   color {0};
+  uint8_t   type {0};
+  float     vx {0};
+  float     vy {0};
+};
+
+// Client side of the DeltaCells section.
+class Decoder {
+public:
+  explicit Decoder(const Buffer& buffer) : m_buffer(buffer) {}
+
+  size_t decode(std::unordered_map<uint32_t, Decoded>& cells)
+  {
+    auto step = std::bit_cast<float>(read<uint32_t>());
+    auto originX = static_cast<int32_t>(read<uint32_t>());
+    auto originY = static_cast<int32_t>(read<uint32_t>());
+    auto count = read<uint16_t>();
+    for (uint16_t i = 0; i < count; ++i) {
+      auto id = readVarint();
+      auto fields = read<uint8_t>();
+      auto& cell = cells[id];
+      if (fields & DeltaEncoder::Full) {
+        cell = {};
+        cell.type = read<uint8_t>() & ~(Cell::isNew | Cell::isMoving);
+      }
+      if (fields & DeltaEncoder::Position) {
+        cell.x = static_cast<float>(originX + read<uint16_t>() - 32768) * step;
+        cell.y = static_cast<float>(originY + read<uint16_t>() - 32768) * step;
+      }
+      if (fields & DeltaEncoder::Mass) {
+        cell.mass = readVarint();
+      }
+      if (fields & DeltaEncoder::Radius) {
+        cell.radius = readVarint();
+      }
+      if (fields & DeltaEncoder::Color) {
+        cell.color = read<uint8_t>();
+      }
+      if (fields & DeltaEncoder::PlayerId) {
+        readVarint();
+      }
+      if (fields & DeltaEncoder::Velocity) {
+        cell.vx = static_cast<int16_t>(read<uint16_t>());
+        cell.vy = static_cast<int16_t>(read<uint16_t>());
+      }
+    }
+    REQUIRE(m_offset == m_buffer.size());
+    return count;
+  }
+
+private:
+  template <typename T>
+  T read()
+  {
+    REQUIRE(m_offset + sizeof(T) <= m_buffer.size());
+    T value;
+    std::memcpy(&value, m_buffer.data() + m_offset, sizeof(T));
+    m_offset += sizeof(T);
+    return boost::endian::big_to_native(value);
+  }
+
+  uint32_t readVarint()
+  {
+    uint32_t value = 0;
+    for (int shift = 0; ; shift += 7) {
+      auto byte = read<uint8_t>();
+      value |= static_cast<uint32_t>(byte & 0x7f) << shift;
+      if (!(byte & 0x80)) {
+        return value;
+      }
+    }
+  }
+
+  const Buffer& m_buffer;
+  size_t        m_offset {0};
+};
+
+} // namespace
+
+TEST_CASE("DeltaEncoder: varint", "[DeltaEncoder]")
+{
+  Buffer buffer;
+  serializeVarint(buffer, 0);
+  serializeVarint(buffer, 127);
+  serializeVarint(buffer, 128);
+  serializeVarint(buffer, 300);
+  serializeVarint(buffer, 0xffffffff);
+  REQUIRE(buffer == Buffer{
+    0, 0x7f, char(0x80), 1, char(0xac), 2, char(0xff), char(0xff), char(0xff), char(0xff), 0x0f
+  });
+}
+
+TEST_CASE("DeltaEncoder: the client state follows the cells", "[DeltaEncoder]")
+{
+  auto config = getDefaultRoomConfig();
+  EntityFactoryStub factory(config);
+  auto& engine = factory.engine();
+  std::uniform_real_distribution<float> mass(100, 20000);
+  std::uniform_real_distribution<float> offset(-300, 300);
+
+  const auto step = DeltaEncoder::getStep(config.width, config.height);
+  DeltaEncoder encoder(step);
+  std::vector<Cell*> cells;
+  for (int i = 0; i < 300; ++i) {
+    auto& cell = i % 3 ? static_cast<Cell&>(factory.createFood()) : factory.createVirus();
+    if (i % 3 == 0) {
+      cell.setMass(mass(engine));
+    }
+    cell.position = factory.getRandomPosition(cell.radius);
+    cell.color = i % 13;
+    cells.push_back(&cell);
+  }
+
+  ClientCells known;
+  std::unordered_map<uint32_t, Decoded> client;
+  auto sync = [&](const Vec2D& origin) {
+    Buffer buffer;
+    encoder.begin(buffer, origin);
+    auto countOffset = buffer.size();
+    serialize(buffer, uint16_t{0});
+    uint16_t count = 0;
+    for (auto* cell : cells) {
+      auto [it, inserted] = known.try_emplace(cell->id);
+      count += encoder.encode(buffer, *cell, it->second, inserted);
+    }
+    auto value = boost::endian::native_to_big(count);
+    std::memcpy(buffer.data() + countOffset, &value, sizeof(value));
+    REQUIRE(Decoder(buffer).decode(client) == count);
+
+    for (auto* cell : cells) {
+      const auto& decoded = client.at(cell->id);
+      REQUIRE(decoded.type == cell->type);
+      REQUIRE(std::fabs(decoded.x - cell->position.x) <= step);
+      REQUIRE(std::fabs(decoded.y - cell->position.y) <= step);
+      REQUIRE(decoded.mass == static_cast<uint32_t>(cell->mass));
+      REQUIRE(decoded.radius == static_cast<uint32_t>(cell->radius));
+      REQUIRE(decoded.color == cell->color);
+      REQUIRE(decoded.vx == std::round(cell->velocity.x));
+      REQUIRE(decoded.vy == std::round(cell->velocity.y));
+    }
+    return std::make_pair(count, buffer.size());
+  };
+
+  auto [count, size] = sync(Vec2D(0, 0));
+  REQUIRE(count == cells.size());
+  Buffer full;
+  for (auto* cell : cells) {
+    cell->format(full);
+  }
+  REQUIRE(size * 3 < full.size() * 2);
+
+  // nothing changed: nothing is written
+  REQUIRE(sync(Vec2D(1000, 1000)).first == 0);
+
+  for (size_t i = 0; i < cells.size(); i += 4) {
+    auto& cell = *cells[i];
+    cell.position = factory.getRandomPosition(cell.radius);
+    cell.velocity = {offset(engine), offset(engine)};
+  }
+  for (size_t i = 0; i < cells.size(); i += 6) {
+    cells[i]->setMass(mass(engine));
+  }
+  std::tie(count, size) = sync(Vec2D(3000, 500));
+  REQUIRE(count > 0);
+  REQUIRE(count < cells.size());
+
+  // stopped cells send their zero velocity once
+  for (size_t i = 0; i < cells.size(); i += 4) {
+    cells[i]->velocity.zero();
+  }
+  REQUIRE(sync(Vec2D(3000, 500)).first == (cells.size() + 3) / 4);
+  REQUIRE(sync(Vec2D(3000, 500)).first == 0);
+}
@@ -0,0 +1,89 @@
+// file   : tests/Test_EventQueue.cpp
+// author : sba <bohdan.sadovyak@gmail.com>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "EventQueue.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+TEST_CASE("EventQueue: events are delivered on flush in emission order", "[EventQueue]")
+{
+  EventQueue queue;
+  DeferredEmitter<> death(queue);
+  DeferredEmitter<float> massChange(queue);
+  std::vector<std::string> log;
+  int a, b;
+
+  death.subscribe(&a, [&] { log.emplace_back("a:death"); });
+  death.subscribe(&b, [&] { log.emplace_back("b:death"); });
+  death.subscribe(&a, [&] { log.emplace_back("duplicate"); });
+  massChange.subscribe(&a, [&](float delta) {
+    log.push_back("a:mass " + std::to_string(static_cast<int>(delta)));
+    if (delta > 0) {
+      massChange.emit(-delta);                // emitted while flushing: delivered after the queued events
+    }
+  });
+
+  massChange.emit(5);
+  death.emit();
+  massChange.emit(7);
+  REQUIRE(log.empty());
+  REQUIRE(queue.size() == 3);
+
+  queue.flush();
+  REQUIRE(queue.empty());
+  REQUIRE(log == std::vector<std::string> {
+    "a:mass 5", "a:death", "b:death", "a:mass 7", "a:mass -5", "a:mass -7"
+  });
+}
+
+TEST_CASE("EventQueue: emitting without subscribers queues nothing", "[EventQueue]")
+{
+  EventQueue queue;
+  DeferredEmitter<> emitter(queue);
+  emitter.emit();
+  REQUIRE(queue.empty());
+}
+
+TEST_CASE("EventQueue: subscribers changing while an event is delivered", "[EventQueue]")
+{
+  EventQueue queue;
+  DeferredEmitter<> emitter(queue);
+  std::vector<std::string> log;
+  int a, b, c;
+
+  emitter.subscribe(&a, [&] {
+    log.emplace_back("a");
+    emitter.unsubscribe(&a);
+    emitter.unsubscribe(&b);
+    emitter.subscribe(&c, [&] { log.emplace_back("c"); });
+  });
+  emitter.subscribe(&b, [&] { log.emplace_back("b"); });
+
+  emitter.emit();
+  emitter.emit();
+  queue.flush();
+  REQUIRE(log == std::vector<std::string> {"a", "c"});
+}
+
+TEST_CASE("EventQueue: events of a destroyed emitter are dropped", "[EventQueue]")
+{
+  EventQueue queue;
+  DeferredEmitter<> survivor(queue);
+  auto doomed = std::make_unique<DeferredEmitter<float>>(queue);
+  std::vector<std::string> log;
+  int tag;
+
+  survivor.subscribe(&tag, [&] { log.emplace_back("survivor"); });
+  doomed->subscribe(&tag, [&](float) { log.emplace_back("doomed"); });
+  doomed->emit(1);
+  survivor.emit();
+  doomed->emit(2);
+  doomed.reset();
+
+  queue.flush();
+  REQUIRE(log == std::vector<std::string> {"survivor"});
+}
@@ -0,0 +1,103 @@
+// file   : tests/Test_FrameCache.cpp
+// author : sba <bohdan.sadovyak@gmail.com>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "CellRegistry.hpp"
+#include "DefaultRoomConfig.hpp"
+#include "EntityFactoryStub.hpp"
+#include "FrameCache.hpp"
+
+#include <boost/endian/conversion.hpp>
+
+#include <cstring>
+#include <set>
+
+namespace {
+
+// Ids of the records in a buffer of concatenated Cell::format records (no avatars).
+std::multiset<uint32_t> decodeIds(const Buffer& buffer)
+{
+  std::multiset<uint32_t> ids;
+  size_t offset = 0;
+  while (offset < buffer.size()) {
+    auto flags = static_cast<uint8_t>(buffer[offset]);
+    uint32_t id;
+    std::memcpy(&id, buffer.data() + offset + 1, sizeof(id));
+    ids.insert(boost::endian::big_to_native(id));
+    offset += 1 + 4 + 4 + 4 + 4 + 2 + 1 + (flags & Cell::isMoving ? 8 : 0);
+  }
+  return ids;
+}
+
+} // namespace
+
+TEST_CASE("FrameCache: viewport assembly matches the per-player selection", "[FrameCache]")
+{
+  auto config = getDefaultRoomConfig();
+  EntityFactoryStub factory(config);
+  auto& gridmap = factory.getGridmap();
+  CellRegistry modified(0);
+  std::uniform_real_distribution<float> mass(10, 20000);
+  auto& engine = factory.engine();
+
+  std::vector<Cell*> cells;
+  for (int i = 0; i < 3000; ++i) {
+    auto& cell = i % 10 ? static_cast<Cell&>(factory.createFood()) : factory.createVirus();
+    cell.setMass(i % 10 ? 5 : mass(engine));
+    cell.position = factory.getRandomPosition(cell.radius);
+    if (i % 7 == 0) {
+      cell.velocity = {1, 2};
+    }
+    cells.push_back(&cell);
+    if (i % 3) {
+      modified.insert(&cell);
+    }
+  }
+
+  FrameCache frames;
+  frames.build(gridmap, modified);
+  REQUIRE(frames.records().size() == modified.size());
+  REQUIRE(decodeIds(frames.data()).size() == modified.size());
+
+  std::uniform_real_distribution<float> x(-500, config.width);
+  std::uniform_real_distribution<float> y(-500, config.height);
+  std::uniform_real_distribution<float> size(100, 3000);
+  for (int i = 0; i < 50; ++i) {
+    Vec2D corner(x(engine), y(engine));
+    AABB viewport(gridmap.clip(AABB(corner, corner + Vec2D(size(engine), size(engine)))));
+    SectorRange range;
+    REQUIRE(gridmap.getSectorRange(viewport, range));
+    AABB viewbox(
+      gridmap.getSector(viewport.a)->box.a,
+      gridmap.getSector(viewport.b)->box.b
+    );
+
+    Buffer buffer;
+    for (auto row = range.rowStart; row <= range.rowEnd; ++row) {
+      frames.append(buffer, frames.getRow(row, range.colStart, range.colEnd));
+    }
+    for (const auto& record : frames.getBorder()) {
+      if (!frames.isInside(record, range) && record.cell->intersects(viewbox)) {
+        frames.append(buffer, {&record, 1});
+      }
+    }
+
+    // sector boxes are inclusive integer boxes, so a food whose center lies between two of them is sent with its
+    // home sector although Food::intersects would not see it in the viewbox
+    std::multiset<uint32_t> expected;
+    for (auto* cell : modified.cells()) {
+      SectorRange home;
+      const auto& position = cell->position;
+      REQUIRE(gridmap.getSectorRange(AABB(position, position), home));
+      if (range.contains(home.rowStart, home.colStart) || cell->intersects(viewbox)) {
+        expected.insert(cell->id);
+      }
+    }
+    REQUIRE(decodeIds(buffer) == expected);
+  }
+
+  for (auto* cell : cells) {
+    REQUIRE(frames.isModified(cell) == modified.contains(cell));
+  }
+}
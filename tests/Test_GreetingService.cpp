@@ -0,0 +1,125 @@
+// file   : tests/Test_GreetingService.cpp
+// author : sba <bohdan.sadovyak@gmail.com>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "GreetingService.hpp"
+#include "User.hpp"
+#include "UserStorageStub.hpp"
+#include "UsersCache.hpp"
+
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/strand.hpp>
+
+#include <atomic>
+#include <future>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Workers {
+  explicit Workers(int count)
+  {
+    for (int i = 0; i < count; ++i) {
+      threads.emplace_back([this] { ioContext.run(); });
+    }
+  }
+
+  ~Workers()
+  {
+    guard.reset();
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+
+  asio::io_context          ioContext;
+  asio::executor_work_guard<asio::io_context::executor_type> guard {ioContext.get_executor()};
+  std::vector<std::thread>  threads;
+};
+
+GreetingService::Result greet(GreetingService& service, const std::string& token, asio::io_context& handlerContext)
+{
+  std::promise<GreetingService::Result> promise;
+  auto future = promise.get_future();
+  service.greet(token, 0x7f000001, handlerContext.get_executor(),
+    [&](const GreetingService::Result& result) { promise.set_value(result); }
+  );
+  return future.get();
+}
+
+} // namespace
+
+TEST_CASE("GreetingService: known tokens find their user, unknown ones register", "[GreetingService]")
+{
+  UserStorageStub storage;
+  storage.add("known", 7);
+  UsersCache users(storage);
+  Workers db(2);
+  Workers io(1);
+  GreetingService service(db.ioContext.get_executor(), users);
+
+  auto known = greet(service, "known", io.ioContext);
+  REQUIRE(known.user);
+  REQUIRE(known.user->getId() == 7);
+  REQUIRE_FALSE(known.created);
+
+  auto fresh = greet(service, "unknown", io.ioContext);
+  REQUIRE(fresh.user);
+  REQUIRE(fresh.created);
+  REQUIRE(fresh.user->getToken().size() == 32);
+
+  auto again = greet(service, fresh.user->getToken(), io.ioContext);
+  REQUIRE(again.user == fresh.user);
+  REQUIRE_FALSE(again.created);
+}
+
+TEST_CASE("GreetingService: the handler runs on the given executor", "[GreetingService]")
+{
+  UserStorageStub storage;
+  UsersCache users(storage);
+  Workers db(1);
+  Workers io(1);
+  GreetingService service(db.ioContext.get_executor(), users);
+
+  std::promise<bool> promise;
+  auto strand = asio::make_strand(io.ioContext);
+  service.greet("token", 0, strand,
+    [&](const GreetingService::Result&) { promise.set_value(strand.running_in_this_thread()); }
+  );
+  REQUIRE(promise.get_future().get());
+}
+
+TEST_CASE("GreetingService: lookups of different tokens run in parallel", "[GreetingService]")
+{
+  static constexpr size_t Greetings = 4;
+
+  UserStorageStub storage;
+  for (uint32_t i = 0; i < Greetings; ++i) {
+    storage.add("token" + std::to_string(i), i + 1);
+  }
+  storage.holdUntil(Greetings);  // each lookup waits for the others to start
+  UsersCache users(storage);
+  Workers db(Greetings);
+  Workers io(1);
+  GreetingService service(db.ioContext.get_executor(), users);
+
+  std::atomic<size_t> found {0};
+  std::promise<void> done;
+  for (uint32_t i = 0; i < Greetings; ++i) {
+    service.greet("token" + std::to_string(i), 0, io.ioContext.get_executor(),
+      [&, id = i + 1](const GreetingService::Result& result) {
+        if (result.user && result.user->getId() == id) {
+          ++found;
+        }
+        if (found == Greetings) {
+          done.set_value();
+        }
+      }
+    );
+  }
+  REQUIRE(done.get_future().wait_for(10s) == std::future_status::ready);
+  REQUIRE(storage.maxConcurrent() == Greetings);
+}
@@ -0,0 +1,451 @@
+// file   : tests/Test_Gridmap.cpp
+// author : sba <bohdan.sadovyak@gmail.com>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "DefaultRoomConfig.hpp"
+#include "EntityFactoryStub.hpp"
+
+#include "geometry/geometry.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <set>
+
+namespace {
+
+std::vector<Cell*> populate(EntityFactoryStub& factory, int foodQuantity, int avatarQuantity)
+{
+  std::vector<Cell*> cells;
+  std::uniform_real_distribution<float> mass(35, 5000);
+  for (int i = 0; i < foodQuantity; ++i) {
+    auto& food = factory.createFood();
+    food.position = factory.getRandomPosition(food.radius);
+    food.setMass(5);
+    cells.push_back(&food);
+  }
+  for (int i = 0; i < avatarQuantity; ++i) {
+    auto& avatar = factory.createAvatar();
+    avatar.setMass(mass(factory.engine()));
+    avatar.position = factory.getRandomPosition(avatar.radius);
+    cells.push_back(&avatar);
+  }
+  for (auto* cell : cells) {
+    factory.getGridmap().insert(cell);
+  }
+  return cells;
+}
+
+std::set<Cell*> queryAll(const Gridmap& gridmap, const AABB& box)
+{
+  std::set<Cell*> result;
+  gridmap.query(box, [&](Cell& cell) { result.insert(&cell); return true; });
+  return result;
+}
+
+std::set<Cell*> bruteForce(const std::vector<Cell*>& cells, const Gridmap& gridmap, const AABB& box)
+{
+  std::set<Cell*> result;
+  for (auto* cell : cells) {
+    bool indexed = !cell->sectors.empty() || !cell->quadtreeSlot.empty();
+    if (indexed && cell->intersects(gridmap.clip(box))) {
+      result.insert(cell);
+    }
+  }
+  return result;
+}
+
+// True if the collectPairs query of `cell` reports `target` (food is seen only by queries of food).
+bool reaches(const Gridmap& gridmap, const Cell& cell, const Cell& target)
+{
+  if (target.materialPoint && !cell.materialPoint) {
+    return false;
+  }
+  Circle bounds(target.position, target.materialPoint ? 0 : target.radius);
+  return geometry::intersects(gridmap.clip(cell.getAABB()), bounds);
+}
+
+} // namespace
+
+TEST_CASE("Gridmap query matches brute force", "[Gridmap]")
+{
+  auto config = getDefaultRoomConfig();
+  EntityFactoryStub factory(config);
+  auto& gridmap = factory.getGridmap();
+  const auto& cells = populate(factory, 2000, 50);
+
+  for (const auto* cell : cells) {
+    REQUIRE(!cell->sectors.empty());
+  }
+
+  std::vector<AABB> boxes {
+    {0, 0, 6143, 6143},
+    {100, 100, 700, 500},
+    {1000, 2000, 1800, 2600},
+    {5000, 5000, 7000, 7000},
+    {-100, -100, 300, 300},
+  };
+  std::vector<Cell*> buffer;
+  for (const auto& box : boxes) {
+    const auto& expected = bruteForce(cells, gridmap, box);
+    REQUIRE(queryAll(gridmap, box) == expected);
+    gridmap.collect(box, buffer);
+    REQUIRE(std::set<Cell*>(buffer.begin(), buffer.end()) == expected);
+  }
+}
+
+TEST_CASE("Gridmap erase and update keep sectors consistent", "[Gridmap]")
+{
+  auto config = getDefaultRoomConfig();
+  EntityFactoryStub factory(config);
+  auto& gridmap = factory.getGridmap();
+  auto cells = populate(factory, 1000, 30);
+  AABB world(0, 0, 6143, 6143);
+
+  for (size_t i = 0; i < cells.size(); i += 3) {
+    gridmap.erase(cells[i]);
+    REQUIRE(cells[i]->sectors.empty());
+  }
+  std::erase_if(cells, [](Cell* cell) { return cell->sectors.empty(); });
+  REQUIRE(queryAll(gridmap, world) == std::set<Cell*>(cells.begin(), cells.end()));
+
+  for (auto* cell : cells) {
+    cell->position = factory.getRandomPosition(cell->radius);
+    gridmap.update(cell);
+  }
+  AABB box(2048, 1024, 3500, 4000);
+  REQUIRE(queryAll(gridmap, box) == bruteForce(cells, gridmap, box));
+}
+
+TEST_CASE("Gridmap query tracks radius changes", "[Gridmap]")
+{
+  auto config = getDefaultRoomConfig();
+  EntityFactoryStub factory(config);
+  auto& gridmap = factory.getGridmap();
+
+  auto& avatar = factory.createAvatar();
+  avatar.setMass(100);
+  avatar.position = {1000, 1000};
+  gridmap.insert(&avatar);
+
+  AABB box(1100, 1000, 1200, 1100);
+  REQUIRE(queryAll(gridmap, box).empty());
+
+  avatar.setMass(2000);
+  gridmap.update(&avatar);
+  REQUIRE(queryAll(gridmap, box) == std::set<Cell*>{&avatar});
+}
+
+TEST_CASE("Gridmap count skips zombies", "[Gridmap]")
+{
+  auto config = getDefaultRoomConfig();
+  EntityFactoryStub factory(config);
+  auto& gridmap = factory.getGridmap();
+
+  std::vector<Food*> foods;
+  for (int i = 0; i < 10; ++i) {
+    auto& food = factory.createFood();
+    food.position = {100.0f + i * 10, 100};
+    gridmap.insert(&food);
+    foods.push_back(&food);
+  }
+
+  AABB box(0, 0, 200, 200);
+  REQUIRE(gridmap.count(box) == 10);
+  foods[3]->zombie = true;
+  REQUIRE(gridmap.count(box) == 9);
+  gridmap.erase(foods[0]);
+  REQUIRE(gridmap.count(box) == 8);
+  REQUIRE(gridmap.count(AABB(150, 0, 200, 200)) == 5);
+}
+
+TEST_CASE("Gridmap update moves a cell across sector borders", "[Gridmap]")
+{
+  auto config = getDefaultRoomConfig();
+  EntityFactoryStub factory(config);
+  auto& gridmap = factory.getGridmap();
+  auto cells = populate(factory, 500, 20);
+
+  auto& avatar = factory.createAvatar();
+  avatar.setMass(20000);
+  avatar.position = {300, 300};
+  gridmap.insert(&avatar);
+  cells.push_back(&avatar);
+
+  for (int step = 0; step < 60; ++step) {
+    avatar.position += Vec2D(83, 61);
+    avatar.setMass(step % 2 ? 20000 : 500);
+    gridmap.update(&avatar);
+    AABB box(avatar.getAABB());
+    REQUIRE(queryAll(gridmap, box) == bruteForce(cells, gridmap, box));
+  }
+  gridmap.erase(&avatar);
+  cells.pop_back();
+  AABB world(0, 0, 6143, 6143);
+  REQUIRE(queryAll(gridmap, world) == std::set<Cell*>(cells.begin(), cells.end()));
+}
+
+TEST_CASE("Gridmap collectPairs reports each overlapping pair once", "[Gridmap]")
+{
+  auto config = getDefaultRoomConfig();
+  EntityFactoryStub factory(config);
+  auto& gridmap = factory.getGridmap();
+  auto cells = populate(factory, 3000, 40);
+
+  std::vector<Cell*> moving;
+  for (size_t i = 0; i < cells.size(); ++i) {
+    if (i % 7 == 0 || cells[i]->type == Cell::typeAvatar) {
+      moving.push_back(cells[i]);
+    }
+  }
+
+  Gridmap::CellPairs pairs;
+  for (int pass = 0; pass < 2; ++pass) {
+    gridmap.collectPairs(moving, pairs);
+
+    std::set<std::pair<Cell*, Cell*>> unique;
+    for (auto [a, b] : pairs) {
+      REQUIRE(a != b);
+      REQUIRE(unique.emplace(std::min(a, b), std::max(a, b)).second);
+    }
+    for (auto* a : moving) {
+      for (auto* b : cells) {
+        if (a != b && reaches(gridmap, *a, *b)) {
+          REQUIRE(unique.contains({std::min(a, b), std::max(a, b)}));
+        }
+      }
+    }
+    for (auto [a, b] : pairs) {
+      REQUIRE((reaches(gridmap, *a, *b) || reaches(gridmap, *b, *a)));
+    }
+  }
+}
+
+TEST_CASE("Gridmap rebuild keeps cells and updates stats", "[Gridmap]")
+{
+  auto config = getDefaultRoomConfig();
+  EntityFactoryStub factory(config);
+  auto& gridmap = factory.getGridmap();
+  const auto& cells = populate(factory, 2000, 30);
+  AABB world(0, 0, 6143, 6143);
+  AABB box(1000, 2000, 1800, 2600);
+
+  auto stats = gridmap.getStats();
+  REQUIRE(stats.power == 9);
+  REQUIRE(stats.cells == cells.size());
+  REQUIRE(stats.sectors == 144);
+  REQUIRE(std::accumulate(stats.histogram.begin(), stats.histogram.end(), 0u) == stats.sectors);
+
+  for (uint8_t power : {7, 11, 9}) {
+    gridmap.rebuild(power);
+    auto rebuilt = gridmap.getStats();
+    REQUIRE(rebuilt.power == power);
+    REQUIRE(rebuilt.cells == cells.size());
+    REQUIRE(rebuilt.sectors == (6144u >> power) * (6144u >> power));
+    REQUIRE(queryAll(gridmap, world) == std::set<Cell*>(cells.begin(), cells.end()));
+    REQUIRE(queryAll(gridmap, box) == bruteForce(cells, gridmap, box));
+  }
+  REQUIRE(gridmap.getStats().entries == stats.entries);
+}
+
+TEST_CASE("Gridmap suggests coarser sectors for huge queries", "[Gridmap]")
+{
+  auto config = getDefaultRoomConfig();
+  EntityFactoryStub factory(config, 6);
+  auto& gridmap = factory.getGridmap();
+  auto cells = populate(factory, 200, 0);
+
+  std::vector<Cell*> avatars;
+  for (int i = 0; i < 10; ++i) {
+    auto& avatar = factory.createAvatar();
+    avatar.setMass(50000);
+    avatar.position = factory.getRandomPosition(avatar.radius);
+    gridmap.insert(&avatar);
+    avatars.push_back(&avatar);
+  }
+
+  auto power = gridmap.suggestPower(avatars, 6, 11);
+  REQUIRE(power > 6);
+  REQUIRE(power <= 11);
+  REQUIRE(gridmap.suggestPower(std::vector<Cell*>{}, 6, 11) == 6);
+}
+
+TEST_CASE("Gridmap quadtree index matches brute force", "[Gridmap]")
+{
+  auto config = getDefaultRoomConfig();
+  EntityFactoryStub factory(config, 6, Gridmap::Index::Quadtree);
+  auto& gridmap = factory.getGridmap();
+  auto cells = populate(factory, 2000, 50);
+  AABB world(0, 0, 6143, 6143);
+
+  for (const auto* cell : cells) {
+    REQUIRE(cell->sectors.empty());
+    REQUIRE(!cell->quadtreeSlot.empty());
+  }
+  REQUIRE(queryAll(gridmap, world) == std::set<Cell*>(cells.begin(), cells.end()));
+
+  std::vector<AABB> boxes {
+    {100, 100, 700, 500},
+    {1000, 2000, 1800, 2600},
+    {5000, 5000, 7000, 7000},
+    {-100, -100, 300, 300},
+  };
+  for (const auto& box : boxes) {
+    REQUIRE(queryAll(gridmap, box) == bruteForce(cells, gridmap, box));
+    auto expected = std::count_if(cells.begin(), cells.end(), [&](Cell* cell) {
+      return geometry::intersects(gridmap.clip(box), cell->position);
+    });
+    REQUIRE(gridmap.count(box) == static_cast<size_t>(expected));
+  }
+
+  for (size_t i = 0; i < cells.size(); i += 3) {
+    gridmap.erase(cells[i]);
+    REQUIRE(cells[i]->quadtreeSlot.empty());
+  }
+  std::erase_if(cells, [](Cell* cell) { return cell->quadtreeSlot.empty(); });
+  for (auto* cell : cells) {
+    if (cell->type == Cell::typeAvatar) {
+      cell->setMass(cell->mass * 4);
+    }
+    cell->position = factory.getRandomPosition(cell->radius);
+    gridmap.update(cell);
+  }
+  for (const auto& box : boxes) {
+    REQUIRE(queryAll(gridmap, box) == bruteForce(cells, gridmap, box));
+  }
+
+  Gridmap::CellPairs pairs;
+  gridmap.collectPairs(cells, pairs);
+  std::set<std::pair<Cell*, Cell*>> unique;
+  for (auto [a, b] : pairs) {
+    REQUIRE(unique.emplace(std::min(a, b), std::max(a, b)).second);
+  }
+  for (auto* a : cells) {
+    for (auto* b : cells) {
+      if (a != b && reaches(gridmap, *a, *b)) {
+        REQUIRE(unique.contains({std::min(a, b), std::max(a, b)}));
+      }
+    }
+  }
+
+  gridmap.rebuild(8);
+  auto stats = gridmap.getStats();
+  REQUIRE(stats.cells == cells.size());
+  REQUIRE(stats.entries == cells.size());
+  REQUIRE(queryAll(gridmap, world) == std::set<Cell*>(cells.begin(), cells.end()));
+}
+
+TEST_CASE("Gridmap queryPoints reports food strictly inside the circle and inside the box", "[Gridmap]")
+{
+  auto config = getDefaultRoomConfig();
+  for (auto index : {Gridmap::Index::Grid, Gridmap::Index::Quadtree}) {
+    EntityFactoryStub factory(config, 8, index);
+    auto& gridmap = factory.getGridmap();
+    const auto& cells = populate(factory, 3000, 20);
+
+    for (const auto* avatar : cells) {
+      if (avatar->type != Cell::typeAvatar) {
+        continue;
+      }
+      Circle circle(avatar->position, avatar->getFoodReach());
+      for (const auto& box : {avatar->getAABB(), AABB(avatar->position, avatar->position + Vec2D(1000, 1000))}) {
+        std::set<Cell*> found;
+        gridmap.queryPoints(circle, box, [&](Cell& cell) { found.insert(&cell); return true; });
+        std::set<Cell*> expected;
+        for (auto* cell : cells) {
+          auto distance = avatar->radius + cell->radius;
+          if (
+            cell->materialPoint && geometry::squareDistance(avatar->position, cell->position) < distance * distance &&
+            geometry::intersects(box, cell->position)
+          ) {
+            expected.insert(cell);
+          }
+        }
+        REQUIRE(found == expected);
+      }
+    }
+  }
+}
+
+TEST_CASE("Gridmap food pass eats what the AABB query of the eater did", "[Gridmap]")
+{
+  auto config = getDefaultRoomConfig();
+  for (auto index : {Gridmap::Index::Grid, Gridmap::Index::Quadtree}) {
+    EntityFactoryStub factory(config, 8, index);
+    auto& gridmap = factory.getGridmap();
+    auto cells = populate(factory, 3000, 20);
+    auto& mother = factory.createMother();
+    mother.position = factory.getRandomPosition(mother.radius);
+    gridmap.insert(&mother);
+    cells.push_back(&mother);
+    // in reach of the avatar's circle but not under its AABB
+    auto* avatar = *std::find_if(cells.begin(), cells.end(), [](Cell* cell) { return cell->type == Cell::typeAvatar; });
+    auto& corner = factory.createFood();
+    corner.position = avatar->position + Vec2D(avatar->radius + corner.radius / 2, 0);
+    gridmap.insert(&corner);
+    cells.push_back(&corner);
+    REQUIRE(geometry::intersects(Circle(avatar->position, avatar->getFoodReach()), corner.position));
+
+    for (auto* eater : cells) {
+      auto reach = eater->getFoodReach();
+      if (reach <= 0) {
+        continue;
+      }
+      std::set<Cell*> eaten;
+      gridmap.queryPoints(Circle(eater->position, reach), eater->getAABB(), [&](Cell& food) {
+        eaten.insert(&food);
+        return true;
+      });
+      // the pass this one replaced: food paired through the eater's query, then the distance check of interact()
+      std::set<Cell*> expected;
+      gridmap.query(eater->getAABB(), [&](Cell& food) {
+        if (geometry::squareDistance(eater->position, food.position) < reach * reach) {
+          expected.insert(&food);
+        }
+        return true;
+      }, Gridmap::Points);
+      REQUIRE(eaten == expected);
+    }
+  }
+}
+
+TEST_CASE("Gridmap keeps a static cell that grows reachable in either index", "[Gridmap]")
+{
+  auto config = getDefaultRoomConfig();
+  for (auto index : {Gridmap::Index::Grid, Gridmap::Index::Quadtree}) {
+    EntityFactoryStub factory(config, 8, index);
+    auto& gridmap = factory.getGridmap();
+    auto& mother = factory.createMother();
+    mother.position = {3000, 3000};
+    mother.setMass(200);
+    REQUIRE_FALSE(gridmap.contains(&mother));
+    gridmap.insert(&mother);
+    REQUIRE(gridmap.contains(&mother));
+    // what Room does on a mass change, the mother does not move so nothing else refreshes its bounds
+    mother.subscribeToMassChange(&gridmap, [&](float) {
+      if (gridmap.contains(&mother)) {
+        gridmap.update(&mother);
+      }
+    });
+
+    auto oldRadius = mother.radius;
+    mother.modifyMass(5000);
+    factory.getGameEvents().flush();
+    REQUIRE(mother.radius > oldRadius * 2);
+
+    // overlaps the new radius only
+    auto& avatar = factory.createAvatar();
+    avatar.setMass(100);
+    avatar.position = {3000 + (oldRadius + mother.radius) / 2 + avatar.radius, 3000};
+    gridmap.insert(&avatar);
+    REQUIRE_FALSE(geometry::intersects(Circle(mother.position, oldRadius), avatar));
+    REQUIRE(geometry::intersects(mother, avatar));
+
+    Gridmap::CellPairs pairs;
+    gridmap.collectPairs(std::vector<Cell*>{&avatar}, pairs);
+    REQUIRE(pairs == Gridmap::CellPairs{{&avatar, &mother}});
+
+    gridmap.erase(&mother);
+    REQUIRE_FALSE(gridmap.contains(&mother));
+  }
+}
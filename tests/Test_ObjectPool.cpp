@@ -0,0 +1,95 @@
+// file   : tests/Test_ObjectPool.cpp
+// author : sba <bohdan.sadovyak@gmail.com>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "ObjectPool.hpp"
+
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+struct Item {
+  explicit Item(int value, bool fail = false) : value(value)
+  {
+    if (fail) {
+      throw std::runtime_error("construction failed");
+    }
+    ++alive;
+  }
+  ~Item() { --alive; }
+
+  static inline int alive {0};
+
+  int     value;
+  double  payload[3] {};
+};
+
+} // namespace
+
+TEST_CASE("ObjectPool: slots are reused and counted", "[ObjectPool]")
+{
+  ObjectPool<Item, 4> pool;
+  REQUIRE(pool.getStats().capacity == 0);
+
+  std::vector<Item*> items;
+  for (int i = 0; i < 6; ++i) {
+    items.push_back(pool.create(i));
+  }
+  REQUIRE(Item::alive == 6);
+  for (int i = 0; i < 6; ++i) {
+    REQUIRE(items[i]->value == i);
+  }
+  auto stats = pool.getStats();
+  REQUIRE(stats.size == 6);
+  REQUIRE(stats.capacity == 8);
+  REQUIRE(stats.highWater == 6);
+
+  std::set<Item*> released {items[1], items[4]};
+  pool.destroy(items[1]);
+  pool.destroy(items[4]);
+  REQUIRE(Item::alive == 4);
+  REQUIRE(pool.getStats().size == 4);
+
+  // freed slots come back before the untouched ones, no new slab is taken
+  items[1] = pool.create(10);
+  items[4] = pool.create(11);
+  REQUIRE(released.contains(items[1]));
+  REQUIRE(released.contains(items[4]));
+  stats = pool.getStats();
+  REQUIRE(stats.size == 6);
+  REQUIRE(stats.capacity == 8);
+  REQUIRE(stats.highWater == 6);
+
+  for (int i = 0; i < 3; ++i) {
+    items.push_back(pool.create(i));
+  }
+  stats = pool.getStats();
+  REQUIRE(stats.capacity == 12);
+  REQUIRE(stats.highWater == 9);
+
+  for (auto* item : items) {
+    pool.destroy(item);
+  }
+  REQUIRE(Item::alive == 0);
+  REQUIRE(pool.getStats().size == 0);
+  REQUIRE(pool.getStats().highWater == 9);
+}
+
+TEST_CASE("ObjectPool: a throwing constructor keeps the slot", "[ObjectPool]")
+{
+  ObjectPool<Item, 2> pool;
+  auto* first = pool.create(1);
+  REQUIRE_THROWS_AS(pool.create(2, true), std::runtime_error);
+  auto stats = pool.getStats();
+  REQUIRE(stats.size == 1);
+  REQUIRE(stats.capacity == 2);
+  auto* second = pool.create(3);
+  REQUIRE(pool.getStats().capacity == 2);
+  pool.destroy(first);
+  pool.destroy(second);
+  REQUIRE(pool.getStats().size == 0);
+  REQUIRE(pool.getStats().highWater == 2);
+}
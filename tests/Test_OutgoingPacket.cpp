@@ -0,0 +1,35 @@
+// file   : tests/Test_OutgoingPacket.cpp
+// author : sba <bohdan.sadovyak@gmail.com>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "Deflater.hpp"
+#include "OutgoingPacket.hpp"
+#include "serialization.hpp"
+
+TEST_CASE("OutgoingPacket: compressed packet sizes are big-endian", "[OutgoingPacket]")
+{
+  Buffer packet;
+  for (uint32_t i = 0; i < 1000; ++i) {
+    serialize(packet, i);
+  }
+  Deflater deflater;
+  Buffer buffer {'x'};
+  OutgoingPacket::serializeCompressed(buffer, packet, deflater);
+  auto compressedSize = buffer.size() - 1 - 1 - 4 - 4;
+  REQUIRE(compressedSize > 0);
+  REQUIRE(compressedSize < 0x10000);
+
+  beast::flat_buffer reader;
+  auto data = reader.prepare(buffer.size() - 1);
+  std::memcpy(data.data(), buffer.data() + 1, data.size());
+  reader.commit(data.size());
+  REQUIRE(deserialize<uint8_t>(reader) == static_cast<uint8_t>(OutgoingPacket::Type::Compressed));
+  REQUIRE(deserialize<uint32_t>(reader) == packet.size());
+  REQUIRE(deserialize<uint32_t>(reader) == compressedSize);
+  // the bytes themselves, as a client reads them
+  REQUIRE(buffer[6] == 0);
+  REQUIRE(buffer[7] == 0);
+  REQUIRE(static_cast<uint8_t>(buffer[8]) == compressedSize >> 8);
+  REQUIRE(static_cast<uint8_t>(buffer[9]) == (compressedSize & 0xff));
+}
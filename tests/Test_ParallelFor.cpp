@@ -0,0 +1,64 @@
+// file   : tests/Test_ParallelFor.cpp
+// author : sba <bohdan.sadovyak@gmail.com>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "ParallelFor.hpp"
+
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/io_context.hpp>
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+TEST_CASE("parallelFor: every index runs once", "[ParallelFor]")
+{
+  asio::io_context ioContext;
+  auto guard = asio::make_work_guard(ioContext);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 3; ++i) {
+    threads.emplace_back([&] { ioContext.run(); });
+  }
+
+  for (uint32_t workers : {0u, 1u, 4u, 16u}) {
+    std::vector<std::atomic<int>> calls(1000);
+    parallelFor(ioContext.get_executor(), calls.size(), workers, [&](size_t i) { ++calls[i]; });
+    for (const auto& count : calls) {
+      REQUIRE(count == 1);
+    }
+  }
+
+  std::atomic<int> calls {0};
+  REQUIRE_THROWS_AS(
+    parallelFor(ioContext.get_executor(), 100, 4, [&](size_t i) {
+      ++calls;
+      if (i % 10 == 3) {
+        throw std::runtime_error("failed");
+      }
+    }),
+    std::runtime_error
+  );
+  REQUIRE(calls == 100);
+
+  guard.reset();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+TEST_CASE("parallelFor: does not wait for a pool that is not running", "[ParallelFor]")
+{
+  asio::io_context ioContext;
+  std::vector<int> calls(50);
+  parallelFor(ioContext.get_executor(), calls.size(), 8, [&](size_t i) { ++calls[i]; });
+  for (auto count : calls) {
+    REQUIRE(count == 1);
+  }
+  // the helpers still queued find nothing left to do
+  ioContext.run();
+  for (auto count : calls) {
+    REQUIRE(count == 1);
+  }
+}
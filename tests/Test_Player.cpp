@@ -0,0 +1,234 @@
+// file   : tests/Test_Player.cpp
+// author : sba <bohdan.sadovyak@gmail.com>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "CellRegistry.hpp"
+#include "DefaultRoomConfig.hpp"
+#include "EntityFactoryStub.hpp"
+#include "FrameCache.hpp"
+#include "OutgoingPacket.hpp"
+#include "Player.hpp"
+#include "Session.hpp"
+#include "serialization.hpp"
+
+#include <cmath>
+#include <future>
+#include <memory>
+#include <set>
+#include <thread>
+
+namespace {
+
+// Websocket client of a Session over loopback, keeping the ids of the cells the frames it receives leave it with.
+class Client {
+public:
+  Client()
+  {
+    tcp::acceptor acceptor(m_ioContext, tcp::endpoint(asio::ip::address_v4::loopback(), 0));
+    m_socket.next_layer().connect(acceptor.local_endpoint());
+    m_session = std::make_shared<Session>(acceptor.accept());
+    std::promise<void> opened;
+    m_session->setOpenHandler([&](const SessionPtr&) { opened.set_value(); });
+    m_session->run();
+    m_thread = std::thread([this] { m_ioContext.run(); });
+    m_socket.handshake("localhost", "/");
+    opened.get_future().wait(); // the server may not be done with the handshake yet
+  }
+
+  ~Client()
+  {
+    m_ioContext.stop();
+    m_thread.join();
+  }
+
+  const SessionPtr& getSession() const { return m_session; }
+  const std::set<uint32_t>& getCells() const { return m_cells; }
+
+  // Reads one message and applies the frames in it.
+  void receive()
+  {
+    beast::flat_buffer buffer;
+    m_socket.read(buffer);
+    while (buffer.size()) {
+      REQUIRE(deserialize<uint8_t>(buffer) == static_cast<uint8_t>(OutgoingPacket::Type::Frame));
+      readFrame(buffer);
+    }
+  }
+
+private:
+  enum Flags { Scale = 1, SyncCells = 2, RemovedIds = 4, DirectionToTargetPlayer = 8, Reset = 32 };
+
+  void readFrame(beast::flat_buffer& buffer)
+  {
+    auto flags = deserialize<uint8_t>(buffer);
+    if (flags & Reset) {
+      m_cells.clear();
+    }
+    if (flags & Scale) {
+      buffer.consume(sizeof(float));
+    }
+    if (flags & SyncCells) {
+      auto count = deserialize<uint16_t>(buffer);
+      std::set<uint32_t> ids;
+      for (uint16_t i = 0; i < count; ++i) {
+        auto type = deserialize<uint8_t>(buffer);
+        auto id = deserialize<uint32_t>(buffer);
+        REQUIRE(ids.insert(id).second); // once per frame
+        m_cells.insert(id);
+        auto size = 4 + 4 + 4 + 2 + 1 + ((type & 63) == Cell::typeAvatar ? 4 : 0) + (type & Cell::isMoving ? 8 : 0);
+        buffer.consume(size);
+      }
+    }
+    if (flags & RemovedIds) {
+      auto count = deserialize<uint16_t>(buffer);
+      for (uint16_t i = 0; i < count; ++i) {
+        REQUIRE(m_cells.erase(deserialize<uint32_t>(buffer)));
+      }
+    }
+    buffer.consume(deserialize<uint8_t>(buffer) * (4 + 4)); // avatars
+    if (flags & DirectionToTargetPlayer) {
+      deserialize<uint8_t>(buffer);
+    }
+  }
+
+  asio::io_context                    m_ioContext;
+  websocket::stream<tcp::socket>      m_socket {m_ioContext};
+  SessionPtr                          m_session;
+  std::thread                         m_thread;
+  std::set<uint32_t>                  m_cells;
+};
+
+class TestPlayer : public Player {
+public:
+  using Player::Player;
+  using Player::addAvatar;
+};
+
+// A player whose viewport is moved by hand, with a client connected to it.
+struct Viewer {
+  Viewer(EntityFactoryStub& factory, const config::Room& config)
+    : player(std::make_shared<TestPlayer>(ioContext.get_executor(), factory, config, 1))
+  {
+    player->addSession(client.getSession());
+    player->respawn();
+  }
+
+  void moveTo(const Vec2D& position)
+  {
+    player->findTheBiggestAvatar()->position = position;
+    player->calcParams();
+  }
+
+  void synchronize(const FrameCache& frames)
+  {
+    player->synchronize(frames, {});
+    client.receive();
+  }
+
+  asio::io_context            ioContext;          // the player's timers never fire
+  Client                      client;
+  std::shared_ptr<TestPlayer> player;
+};
+
+// Ids of the cells homed in the sectors of the player's viewbox, which is what its client should have.
+std::set<uint32_t> getExpected(const Gridmap& gridmap, const std::vector<Cell*>& cells, const Player& player)
+{
+  SectorRange range;
+  REQUIRE(gridmap.getSectorRange(player.getViewBox(), range));
+  std::set<uint32_t> expected;
+  for (auto* cell : cells) {
+    SectorRange home;
+    REQUIRE(gridmap.getSectorRange(AABB(cell->position, cell->position), home));
+    if (range.contains(home.rowStart, home.colStart)) {
+      expected.insert(cell->id);
+    }
+  }
+  return expected;
+}
+
+} // namespace
+
+TEST_CASE("Player: a gridmap rebuild keeps the client in sync", "[Player]")
+{
+  auto config = getDefaultRoomConfig();
+  EntityFactoryStub factory(config);
+  auto& gridmap = factory.getGridmap();
+  std::vector<Cell*> cells;
+  for (int i = 0; i < 3000; ++i) {
+    auto& food = factory.createFood();
+    const auto& position = factory.getRandomPosition(food.radius);
+    food.position = {std::floor(position.x), std::floor(position.y)};
+    gridmap.insert(&food);
+    cells.push_back(&food);
+  }
+  CellRegistry modified(0);
+  FrameCache frames;
+  frames.build(gridmap, modified);
+
+  Viewer viewer(factory, config);
+  viewer.moveTo({3000, 3000});
+  viewer.synchronize(frames);
+  REQUIRE(viewer.client.getCells() == getExpected(gridmap, cells, *viewer.player));
+
+  for (uint8_t power : {7, 11, 9}) {
+    gridmap.rebuild(power);
+    frames.build(gridmap, modified);
+    viewer.synchronize(frames);
+    REQUIRE(viewer.client.getCells() == getExpected(gridmap, cells, *viewer.player));
+
+    viewer.moveTo({3000.0f + power * 100, 3000});
+    viewer.synchronize(frames);
+    REQUIRE(viewer.client.getCells() == getExpected(gridmap, cells, *viewer.player));
+  }
+}
+
+TEST_CASE("Player: food between two sector boxes comes and goes with its sector", "[Player]")
+{
+  auto config = getDefaultRoomConfig();
+  EntityFactoryStub factory(config);
+  auto& gridmap = factory.getGridmap();
+  std::vector<Cell*> cells;
+  for (const Vec2D& position : {Vec2D(511.5f, 3000), Vec2D(600, 1023.75f), Vec2D(1023.99f, 1023.99f)}) {
+    auto& food = factory.createFood();
+    food.position = position;
+    gridmap.insert(&food);
+    cells.push_back(&food);
+  }
+  CellRegistry modified(0);
+  FrameCache frames;
+  frames.build(gridmap, modified);
+
+  Viewer viewer(factory, config);
+  for (const Vec2D& position : {Vec2D(400, 3000), Vec2D(3000, 3000), Vec2D(800, 1000), Vec2D(400, 3000)}) {
+    viewer.moveTo(position);
+    viewer.synchronize(frames);
+    REQUIRE(viewer.client.getCells() == getExpected(gridmap, cells, *viewer.player));
+  }
+}
+
+TEST_CASE("Player: an own avatar in a viewport sector but out of the viewbox is sent once", "[Player]")
+{
+  auto config = getDefaultRoomConfig();
+  EntityFactoryStub factory(config);
+  CellRegistry modified(0);
+  FrameCache frames;
+  frames.build(factory.getGridmap(), modified);
+
+  Viewer viewer(factory, config);
+  viewer.moveTo({3000, 3000});
+  viewer.synchronize(frames);
+
+  // homed in the last column of the viewport, between its box and the next one
+  const auto& viewbox = viewer.player->getViewBox();
+  auto& avatar = factory.createAvatar();
+  viewer.player->addAvatar(&avatar);
+  avatar.position = {viewbox.b.x + 0.9f, 3000};
+  avatar.radius = 0.25;
+  REQUIRE_FALSE(avatar.intersects(viewbox));
+  modified.insert(&avatar);
+  modified.insert(viewer.player->findTheBiggestAvatar());
+  frames.build(factory.getGridmap(), modified);
+  viewer.synchronize(frames);
+  REQUIRE(viewer.client.getCells().contains(avatar.id));
+}
@@ -0,0 +1,128 @@
+// file   : tests/Test_SessionLogger.cpp
+// author : sba <bohdan.sadovyak@gmail.com>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "SessionLogger.hpp"
+
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Sink {
+  void operator()(std::span<const SessionRecord> records)
+  {
+    std::lock_guard lock(mutex);
+    batches.emplace_back(records.size());
+    for (const auto& record : records) {
+      userIds.emplace_back(record.userId);
+    }
+  }
+
+  std::mutex            mutex;
+  std::vector<size_t>   batches;
+  std::vector<uint32_t> userIds;
+};
+
+SessionRecord makeRecord(uint32_t userId)
+{
+  SessionRecord record;
+  record.userId = userId;
+  record.begin = SystemTimePoint::clock::now();
+  record.end = record.begin;
+  return record;
+}
+
+} // namespace
+
+TEST_CASE("SessionLogger: stop writes everything queued in batches", "[SessionLogger]")
+{
+  Sink sink;
+  SessionLogger logger([&](auto records) { sink(records); });
+  config::SessionLog config;
+  config.flushInterval = 1h;
+  config.batchSize = 10;
+  logger.start(config);
+
+  for (uint32_t i = 0; i < 95; ++i) {
+    logger.log(makeRecord(i));
+  }
+  logger.stop();
+
+  REQUIRE(sink.userIds.size() == 95);
+  for (uint32_t i = 0; i < 95; ++i) {
+    REQUIRE(sink.userIds[i] == i);
+  }
+  for (auto size : sink.batches) {
+    REQUIRE(size <= 10);
+  }
+  auto stats = logger.getStats();
+  REQUIRE(stats.queued == 0);
+  REQUIRE(stats.written == 95);
+  REQUIRE(stats.dropped == 0);
+}
+
+TEST_CASE("SessionLogger: a full batch does not wait for the interval", "[SessionLogger]")
+{
+  Sink sink;
+  SessionLogger logger([&](auto records) { sink(records); });
+  config::SessionLog config;
+  config.flushInterval = 1h;
+  config.batchSize = 4;
+  logger.start(config);
+
+  for (uint32_t i = 0; i < 4; ++i) {
+    logger.log(makeRecord(i));
+  }
+  for (int i = 0; i < 500 && logger.getStats().written < 4; ++i) {
+    std::this_thread::sleep_for(10ms);
+  }
+  REQUIRE(logger.getStats().written == 4);
+  REQUIRE(logger.getStats().flushes == 1);
+}
+
+TEST_CASE("SessionLogger: records beyond the queue size are dropped", "[SessionLogger]")
+{
+  Sink sink;
+  SessionLogger logger([&](auto records) { sink(records); });
+  config::SessionLog config;
+  config.flushInterval = 1h;
+  config.batchSize = 100;
+  config.queueSize = 5;
+  logger.start(config);
+
+  for (uint32_t i = 0; i < 8; ++i) {
+    logger.log(makeRecord(i));
+  }
+  REQUIRE(logger.getStats().queued == 5);
+  REQUIRE(logger.getStats().dropped == 3);
+
+  logger.stop();
+  REQUIRE(sink.userIds == std::vector<uint32_t> {0, 1, 2, 3, 4});
+}
+
+TEST_CASE("SessionLogger: a failed write drops its batch only", "[SessionLogger]")
+{
+  int calls = 0;
+  SessionLogger logger([&](auto) {
+    if (calls++ == 0) {
+      throw std::runtime_error("gone away");
+    }
+  });
+  config::SessionLog config;
+  config.flushInterval = 1h;
+  config.batchSize = 3;
+
+  for (uint32_t i = 0; i < 7; ++i) {
+    logger.log(makeRecord(i));
+  }
+  logger.start(config);
+  logger.stop();
+
+  auto stats = logger.getStats();
+  REQUIRE(stats.dropped == 3);
+  REQUIRE(stats.written == 4);
+}
@@ -0,0 +1,138 @@
+// file   : tests/Test_UserTokenPool.cpp
+// author : sba <bohdan.sadovyak@gmail.com>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "User.hpp"
+#include "UserStorageStub.hpp"
+#include "UserTokenPool.hpp"
+#include "UsersCache.hpp"
+#include "util.hpp"
+
+#include <boost/asio/io_context.hpp>
+
+#include <cctype>
+#include <chrono>
+#include <set>
+#include <string>
+#include <thread>
+
+namespace {
+
+config::TokenPool makeConfig(uint32_t capacity, uint32_t lowWater, uint32_t batchSize)
+{
+  config::TokenPool config;
+  config.capacity = capacity;
+  config.lowWater = lowWater;
+  config.batchSize = batchSize;
+  return config;
+}
+
+} // namespace
+
+TEST_CASE("randomString: alphanumeric and unique", "[UserTokenPool]")
+{
+  std::set<std::string> strings;
+  for (int i = 0; i < 1000; ++i) {
+    auto str = randomString(32);
+    REQUIRE(str.size() == 32);
+    for (char c : str) {
+      REQUIRE(std::isalnum(static_cast<unsigned char>(c)));
+    }
+    strings.insert(str);
+  }
+  REQUIRE(strings.size() == 1000);
+  REQUIRE(randomString(0).empty());
+  REQUIRE(randomString(1000).size() == 1000);
+}
+
+TEST_CASE("UserTokenPool: fills up in batches and refills at the low water mark", "[UserTokenPool]")
+{
+  asio::io_context ioContext;
+  UserStorageStub storage;
+  UserTokenPool pool(ioContext.get_executor(), storage);
+
+  REQUIRE_FALSE(pool.pop());
+  pool.start(makeConfig(10, 3, 4));
+  ioContext.run();
+  ioContext.restart();
+  REQUIRE(pool.getStats().size == 10);
+  REQUIRE(storage.batchInserts() == 3);
+
+  std::set<uint32_t> ids;
+  for (int i = 0; i < 7; ++i) {
+    auto record = pool.pop();
+    REQUIRE(record);
+    REQUIRE(storage.get(record->token)->id == record->id);
+    ids.insert(record->id);
+  }
+  REQUIRE(ids.size() == 7);
+  REQUIRE(pool.getStats().size == 3);
+
+  ioContext.run();
+  auto stats = pool.getStats();
+  REQUIRE(stats.size == 10);
+  REQUIRE(stats.popped == 7);
+  REQUIRE(stats.empty == 1);
+  REQUIRE(stats.inserted == 17);
+}
+
+TEST_CASE("UserTokenPool: UsersCache registers from the pool", "[UserTokenPool]")
+{
+  asio::io_context ioContext;
+  UserStorageStub storage;
+  UserTokenPool pool(ioContext.get_executor(), storage);
+  UsersCache users(storage, &pool);
+  pool.start(makeConfig(100, 10, 50));
+  ioContext.run();
+
+  const auto refilled = *storage.get(pool.pop()->token)->created;
+  std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  auto user = users.create(0x7f000001);
+  REQUIRE(storage.inserts() == 0);
+  REQUIRE(user->getIp() == 0x7f000001);
+  REQUIRE(users.getUserByToken(user->getToken()) == user);
+
+  // registered when handed out, not when the pool was refilled
+  REQUIRE(users.save(100) == 1);
+  auto record = storage.get(user->getToken());
+  REQUIRE(record->ip == 0x7f000001);
+  REQUIRE(record->created == user->getCreated());
+  REQUIRE(*record->created > refilled);
+}
+
+TEST_CASE("UserTokenPool: stop removes the users not handed out", "[UserTokenPool]")
+{
+  asio::io_context ioContext;
+  UserStorageStub storage;
+  UserTokenPool pool(ioContext.get_executor(), storage);
+  pool.start(makeConfig(10, 0, 10));
+  ioContext.run();
+  ioContext.restart();
+
+  auto kept = pool.pop();
+  REQUIRE(kept);
+  pool.stop();
+  REQUIRE(pool.getStats().size == 0);
+  for (uint32_t id = 1000; id < 1010; ++id) {
+    REQUIRE(storage.findById(id).has_value() == (id == kept->id));
+  }
+
+  // nothing is registered once stopped
+  REQUIRE_FALSE(pool.pop());
+  REQUIRE(ioContext.run() == 0);
+}
+
+TEST_CASE("UserTokenPool: UsersCache inserts on its own when the pool is empty", "[UserTokenPool]")
+{
+  asio::io_context ioContext;
+  UserStorageStub storage;
+  UserTokenPool pool(ioContext.get_executor(), storage);
+  UsersCache users(storage, &pool);
+  pool.start(makeConfig(0, 0, 1));
+
+  auto user = users.create(1);
+  REQUIRE(user);
+  REQUIRE(storage.inserts() == 1);
+  REQUIRE(storage.batchInserts() == 0);
+}
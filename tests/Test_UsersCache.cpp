@@ -0,0 +1,158 @@
+// file   : tests/Test_UsersCache.cpp
+// author : sba <bohdan.sadovyak@gmail.com>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "Session.hpp"
+#include "User.hpp"
+#include "UserStorageStub.hpp"
+#include "UserTokenPool.hpp"
+#include "UsersCache.hpp"
+
+#include <boost/asio/io_context.hpp>
+
+#include <set>
+#include <thread>
+#include <vector>
+
+TEST_CASE("UsersCache: counts hits and misses", "[UsersCache]")
+{
+  UserStorageStub storage;
+  UsersCache users(storage);
+
+  auto user = users.create(0);
+  REQUIRE(users.getUserByToken(user->getToken()) == user);
+  REQUIRE(users.getUserById(user->getId()) == user);
+  REQUIRE_FALSE(users.getUserByToken("nobody"));
+
+  auto stats = users.getStats();
+  REQUIRE(stats.size == 1);
+  REQUIRE(stats.hits == 2);
+  REQUIRE(stats.misses == 1);
+}
+
+TEST_CASE("UsersCache: evicts idle users without a session and reloads them", "[UsersCache]")
+{
+  asio::io_context ioContext;
+  UserStorageStub storage;
+  UsersCache users(storage);
+
+  std::vector<UserPtr> created;
+  for (int i = 0; i < 100; ++i) {
+    created.emplace_back(users.create(0));
+  }
+  const auto& session = std::make_shared<Session>(tcp::socket(ioContext));
+  created[42]->setSession(session);
+
+  REQUIRE(users.evict(1h) == 0);
+  std::this_thread::sleep_for(1ms);
+  REQUIRE(users.evict(Duration::zero()) == 99);
+  auto stats = users.getStats();
+  REQUIRE(stats.size == 1);
+  REQUIRE(stats.evictions == 99);
+  REQUIRE(users.getUserByToken(created[42]->getToken()) == created[42]);
+
+  // evicted users come back from the storage as new objects
+  auto reloaded = users.getUserByToken(created[7]->getToken());
+  REQUIRE(reloaded);
+  REQUIRE(reloaded != created[7]);
+  REQUIRE(reloaded->getId() == created[7]->getId());
+
+  created[42]->releaseSession(session);
+  std::this_thread::sleep_for(1ms);
+  REQUIRE(users.evict(Duration::zero()) == 2);
+}
+
+TEST_CASE("UsersCache: concurrent lookups of the same user share one object", "[UsersCache]")
+{
+  UserStorageStub storage;
+  std::vector<std::string> tokens;
+  {
+    UsersCache users(storage);
+    for (int i = 0; i < 50; ++i) {
+      tokens.emplace_back(users.create(0)->getToken());
+    }
+  }
+
+  UsersCache users(storage);
+  std::vector<std::vector<UserPtr>> found(4);
+  std::vector<std::thread> threads;
+  for (auto& result : found) {
+    threads.emplace_back([&] {
+      for (const auto& token : tokens) {
+        result.emplace_back(users.getUserByToken(token));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (const auto& result : found) {
+    REQUIRE(result == found.front());
+  }
+  std::set<UserPtr> distinct(found.front().begin(), found.front().end());
+  REQUIRE(distinct.size() == tokens.size());
+  REQUIRE(users.getStats().size == tokens.size());
+}
+
+TEST_CASE("UsersCache: saves only modified users in batches", "[UsersCache]")
+{
+  asio::io_context ioContext;
+  UserStorageStub storage;
+  UserTokenPool pool(ioContext.get_executor(), storage);
+  UsersCache users(storage, &pool);
+  config::TokenPool config;
+  config.capacity = 25;
+  config.lowWater = 0;
+  config.batchSize = 25;
+  pool.start(config);
+  ioContext.run();
+
+  for (uint32_t i = 0; i < 25; ++i) {
+    users.create(i + 1); // taken from the pool, the ip is yet to be written
+  }
+  REQUIRE(pool.getStats().size == 0);
+  users.create(0); // the pool is empty: inserted with its ip, nothing to save
+  REQUIRE(storage.inserts() == 1);
+  REQUIRE(users.getStats().modified == 25);
+
+  REQUIRE(users.save(10) == 25);
+  REQUIRE(storage.updateSizes() == std::vector<size_t> {10, 10, 5});
+  REQUIRE(users.save(10) == 0);
+  REQUIRE(storage.updates() == 3);
+  auto stats = users.getStats();
+  REQUIRE(stats.modified == 0);
+  REQUIRE(stats.saved == 25);
+}
+
+TEST_CASE("UsersCache: users are kept modified when the save fails", "[UsersCache]")
+{
+  asio::io_context ioContext;
+  UserStorageStub storage;
+  UserTokenPool pool(ioContext.get_executor(), storage);
+  UsersCache users(storage, &pool);
+  config::TokenPool config;
+  config.capacity = 10;
+  config.lowWater = 0;
+  config.batchSize = 10;
+  pool.start(config);
+  ioContext.run();
+
+  std::vector<UserPtr> created;
+  for (uint32_t i = 0; i < 10; ++i) {
+    created.emplace_back(users.create(i + 1));
+  }
+  storage.failUpdates(1);
+  REQUIRE_THROWS(users.save(4));
+  REQUIRE(users.getStats().modified == 10);
+
+  // unsaved users are not evicted
+  std::this_thread::sleep_for(1ms);
+  REQUIRE(users.evict(Duration::zero()) == 0);
+
+  REQUIRE(users.save(4) == 10);
+  for (const auto& user : created) {
+    REQUIRE(storage.get(user->getToken())->ip == user->getIp());
+  }
+  REQUIRE(users.evict(Duration::zero()) == 10);
+}
@@ -0,0 +1,147 @@
+// file   : tests/UserStorageStub.hpp
+// author : sba <bohdan.sadovyak@gmail.com>
+
+#ifndef THEGAME_TESTS_USER_STORAGE_STUB_HPP
+#define THEGAME_TESTS_USER_STORAGE_STUB_HPP
+
+#include "UserStorage.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+// In-memory users table for unit tests. Token lookups can be held until a number of them are in flight at once.
+class UserStorageStub final : public UserStorage {
+public:
+  std::optional<UserRecord> findById(uint32_t id) override
+  {
+    std::lock_guard lock(m_mutex);
+    for (const auto& [token, record] : m_users) {
+      if (record.id == id) {
+        return record;
+      }
+    }
+    return {};
+  }
+
+  std::optional<UserRecord> findByToken(const std::string& token) override
+  {
+    std::unique_lock lock(m_mutex);
+    ++m_lookups;
+    m_condition.notify_all();
+    m_condition.wait_for(lock, std::chrono::seconds(5), [&] { return m_lookups >= m_holdUntil; });
+    m_maxConcurrent = std::max(m_maxConcurrent, m_lookups);
+    if (const auto& it = m_users.find(token); it != m_users.end()) {
+      return it->second;
+    }
+    return {};
+  }
+
+  uint32_t insert(const std::string& token, uint32_t ip, SystemTimePoint created) override
+  {
+    std::lock_guard lock(m_mutex);
+    ++m_inserts;
+    return addLocked(token, ip, 0, created);
+  }
+
+  std::vector<UserRecord> insert(std::span<const std::string> tokens, SystemTimePoint created) override
+  {
+    std::lock_guard lock(m_mutex);
+    ++m_batchInserts;
+    std::vector<UserRecord> result;
+    for (const auto& token : tokens) {
+      if (auto id = addLocked(token, 0, 0, created)) {
+        result.push_back({id, token, 0, {}});
+      }
+    }
+    return result;
+  }
+
+  void update(std::span<const UserRecord> records) override
+  {
+    std::lock_guard lock(m_mutex);
+    if (m_failUpdates) {
+      --m_failUpdates;
+      throw std::runtime_error("update failed");
+    }
+    ++m_updates;
+    m_updateSizes.push_back(records.size());
+    for (const auto& record : records) {
+      auto& user = m_users[record.token];
+      auto created = record.created ? record.created : user.created;
+      user = record;
+      user.created = created;
+    }
+  }
+
+  void remove(std::span<const uint32_t> ids) override
+  {
+    std::lock_guard lock(m_mutex);
+    std::erase_if(m_users, [&](const auto& item) { return std::ranges::find(ids, item.second.id) != ids.end(); });
+  }
+
+  void add(const std::string& token, uint32_t id)
+  {
+    std::lock_guard lock(m_mutex);
+    addLocked(token, 0, id, SystemTimePoint::clock::now());
+  }
+
+  std::optional<UserRecord> get(const std::string& token)
+  {
+    std::lock_guard lock(m_mutex);
+    if (const auto& it = m_users.find(token); it != m_users.end()) {
+      return it->second;
+    }
+    return {};
+  }
+
+  void holdUntil(size_t lookups)
+  {
+    std::lock_guard lock(m_mutex);
+    m_holdUntil = lookups;
+  }
+
+  // The next `count` updates throw.
+  void failUpdates(size_t count)
+  {
+    std::lock_guard lock(m_mutex);
+    m_failUpdates = count;
+  }
+
+  size_t maxConcurrent() const
+  {
+    std::lock_guard lock(m_mutex);
+    return m_maxConcurrent;
+  }
+
+  size_t inserts() const { std::lock_guard lock(m_mutex); return m_inserts; }
+  size_t batchInserts() const { std::lock_guard lock(m_mutex); return m_batchInserts; }
+  size_t updates() const { std::lock_guard lock(m_mutex); return m_updates; }
+  std::vector<size_t> updateSizes() const { std::lock_guard lock(m_mutex); return m_updateSizes; }
+
+private:
+  uint32_t addLocked(const std::string& token, uint32_t ip, uint32_t id, SystemTimePoint created)
+  {
+    id = id ? id : m_nextId++;
+    return m_users.emplace(token, UserRecord {id, token, ip, created}).second ? id : 0;
+  }
+
+  mutable std::mutex                m_mutex;
+  std::condition_variable           m_condition;
+  std::map<std::string, UserRecord> m_users;
+  uint32_t                          m_nextId {1000};
+  size_t                            m_lookups {0};
+  size_t                            m_holdUntil {0};
+  size_t                            m_maxConcurrent {0};
+  size_t                            m_inserts {0};
+  size_t                            m_batchInserts {0};
+  size_t                            m_updates {0};
+  size_t                            m_failUpdates {0};
+  std::vector<size_t>               m_updateSizes;
+};
+
+#endif /* THEGAME_TESTS_USER_STORAGE_STUB_HPP */
@@ -0,0 +1,46 @@
+// file   : tests/geometry/Benchmark_kernels.cpp
+// author : sba <bohdan.sadovyak@gmail.com>
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include "../../src/geometry/kernels.hpp"
+#include "../../src/geometry/geometry.hpp"
+#include "../../src/geometry/Circle.hpp"
+
+#include <bit>
+#include <random>
+#include <vector>
+
+TEST_CASE("Circle vs packed points: scalar vs kernel", "[.][benchmark][geometry]")
+{
+  constexpr size_t count = 4096;
+  std::mt19937 engine(3);
+  std::uniform_real_distribution<float> coordinate(0, 512);
+  std::vector<Vec2D> points;
+  std::vector<float> xs, ys;
+  for (size_t i = 0; i < count; ++i) {
+    points.emplace_back(coordinate(engine), coordinate(engine));
+    xs.push_back(points.back().x);
+    ys.push_back(points.back().y);
+  }
+  Circle circle(256, 256, 120);
+
+  BENCHMARK("scalar squareDistance")
+  {
+    size_t hits = 0;
+    for (const auto& point : points) {
+      hits += geometry::squareDistance(circle.position, point) < circle.radius * circle.radius;
+    }
+    return hits;
+  };
+
+  BENCHMARK("pointsInCircle kernel")
+  {
+    size_t hits = 0;
+    for (size_t first = 0; first < count; first += geometry::KernelBatchSize) {
+      hits += std::popcount(geometry::pointsInCircle(circle, &xs[first], &ys[first], geometry::KernelBatchSize));
+    }
+    return hits;
+  };
+}
@@ -0,0 +1,79 @@
+// file   : tests/geometry/Test_kernels.cpp
+// author : sba <bohdan.sadovyak@gmail.com>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "../../src/geometry/kernels.hpp"
+#include "../../src/geometry/geometry.hpp"
+#include "../../src/geometry/AABB.hpp"
+#include "../../src/geometry/Circle.hpp"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+TEST_CASE("Points in box kernel matches the scalar test", "[geometry]")
+{
+  std::mt19937 engine(7);
+  std::uniform_real_distribution<float> coordinate(-20, 120);
+  AABB box({10, 20}, {90, 70});
+
+  std::vector<float> xs, ys;
+  for (size_t i = 0; i < geometry::KernelBatchSize; ++i) {
+    xs.push_back(coordinate(engine));
+    ys.push_back(coordinate(engine));
+  }
+  // points exactly on the borders count as inside
+  xs[0] = 10; ys[0] = 20;
+  xs[1] = 90; ys[1] = 70;
+  xs[2] = 90; ys[2] = std::nextafter(70.0f, 100.0f);
+  xs[3] = std::nextafter(10.0f, 0.0f); ys[3] = 50;
+
+  for (size_t count : std::initializer_list<size_t>{0, 1, 3, 4, 5, 31, 63, 64}) {
+    uint64_t expected = 0;
+    for (size_t i = 0; i < count; ++i) {
+      if (geometry::intersects(box, Vec2D(xs[i], ys[i]))) {
+        expected |= uint64_t{1} << i;
+      }
+    }
+    REQUIRE(geometry::pointsInBox(box, xs.data(), ys.data(), count) == expected);
+  }
+  REQUIRE((geometry::pointsInBox(box, xs.data(), ys.data(), 4) & 0b1111) == 0b0011);
+}
+
+TEST_CASE("Circle kernels match the scalar narrow phase bit for bit", "[geometry]")
+{
+  std::mt19937 engine(11);
+  std::uniform_real_distribution<float> coordinate(0, 6144);
+  std::uniform_real_distribution<float> radius(0, 300);
+
+  std::vector<float> xs(geometry::KernelBatchSize), ys(geometry::KernelBatchSize), rs(geometry::KernelBatchSize);
+  for (int round = 0; round < 2000; ++round) {
+    Circle circle(coordinate(engine), coordinate(engine), radius(engine));
+    std::uniform_real_distribution<float> offset(-2 * circle.radius - 10, 2 * circle.radius + 10);
+    for (size_t i = 0; i < geometry::KernelBatchSize; ++i) {
+      xs[i] = circle.position.x + offset(engine);
+      ys[i] = circle.position.y + offset(engine);
+      rs[i] = radius(engine) / 10;
+    }
+    // points exactly on the circle are outside, as in Avatar::interact(Food&)
+    xs[0] = circle.position.x + circle.radius;
+    ys[0] = circle.position.y;
+
+    size_t count = round % (geometry::KernelBatchSize + 1);
+    uint64_t points = 0;
+    uint64_t circles = 0;
+    for (size_t i = 0; i < count; ++i) {
+      Vec2D center(xs[i], ys[i]);
+      if (geometry::squareDistance(circle.position, center) < circle.radius * circle.radius) {
+        points |= uint64_t{1} << i;
+      }
+      auto distance = circle.radius + rs[i];
+      if (geometry::squareDistance(circle.position, center) < distance * distance) {
+        circles |= uint64_t{1} << i;
+      }
+    }
+    REQUIRE(geometry::pointsInCircle(circle, xs.data(), ys.data(), count) == points);
+    REQUIRE(geometry::circlesOverlapCircle(circle, xs.data(), ys.data(), rs.data(), count) == circles);
+  }
+}